@@ -678,6 +678,30 @@ int scoutfs_dalloc_return_cached(struct super_block *sb,
 	return ret;
 }
 
+/*
+ * Return an unused extent that was allocated from the data allocator
+ * back to extent items in the avail root.  Callers use this to give
+ * back allocations they were holding in reserve.
+ */
+int scoutfs_dalloc_return(struct super_block *sb, struct scoutfs_alloc *alloc,
+			  struct scoutfs_block_writer *wri,
+			  struct scoutfs_data_alloc *dalloc, u64 blkno,
+			  u64 count)
+{
+	struct alloc_ext_args args = {
+		.alloc = alloc,
+		.wri = wri,
+		.root = &dalloc->root,
+		.zone = SCOUTFS_FREE_EXTENT_BLKNO_ZONE,
+	};
+	int ret;
+
+	ret = scoutfs_ext_insert(sb, &alloc_ext_ops, &args, blkno, count, 0, 0);
+	if (ret == 0)
+		dalloc_update_total_len(dalloc);
+	return ret;
+}
+
 /*
  * Allocate a data extent.  An extent that's smaller than the requested
  * size can be returned.
@@ -763,6 +787,59 @@ out:
 	return ret;
 }
 
+/*
+ * Allocate a data extent that starts at the given blkno, returning
+ * ENOENT if the blkno isn't free.  Streaming writers use this to
+ * continue allocating from where their previous allocation ended.  An
+ * extent that's smaller than the requested size can be returned.
+ *
+ * This doesn't return ENOBUFS or ENOSPC, the caller is expected to
+ * fall back to _alloc_data when the target block isn't free.
+ */
+int scoutfs_alloc_data_at(struct super_block *sb, struct scoutfs_alloc *alloc,
+			  struct scoutfs_block_writer *wri,
+			  struct scoutfs_data_alloc *dalloc, u64 blkno,
+			  u64 count, u64 *count_ret)
+{
+	struct alloc_ext_args args = {
+		.alloc = alloc,
+		.wri = wri,
+		.root = &dalloc->root,
+		.zone = SCOUTFS_FREE_EXTENT_BLKNO_ZONE,
+	};
+	struct scoutfs_extent ext;
+	u64 len;
+	int ret;
+
+	if (dalloc->cached.len && dalloc->cached.start == blkno) {
+		len = min(count, dalloc->cached.len);
+		dalloc->cached.start += len;
+		dalloc->cached.len -= len;
+		ret = 0;
+		goto out;
+	}
+
+	ret = scoutfs_ext_next(sb, &alloc_ext_ops, &args, blkno, 1, &ext);
+	if (ret == 0 && ext.start > blkno)
+		ret = -ENOENT;
+	if (ret < 0)
+		goto out;
+
+	len = min(count, ext.start + ext.len - blkno);
+	ret = scoutfs_ext_remove(sb, &alloc_ext_ops, &args, blkno, len);
+out:
+	if (ret < 0) {
+		*count_ret = 0;
+	} else {
+		*count_ret = len;
+		dalloc_update_total_len(dalloc);
+	}
+
+	scoutfs_inc_counter(sb, alloc_alloc_data_at);
+	trace_scoutfs_alloc_alloc_data(sb, count, blkno, *count_ret, ret);
+	return ret;
+}
+
 /*
  * Free data extents into the freed tree that will be reclaimed by the
  * server and made available for future allocators only if our
@@ -116,10 +116,18 @@ int scoutfs_dalloc_return_cached(struct super_block *sb,
 				 struct scoutfs_alloc *alloc,
 				 struct scoutfs_block_writer *wri,
 				 struct scoutfs_data_alloc *dalloc);
+int scoutfs_dalloc_return(struct super_block *sb, struct scoutfs_alloc *alloc,
+			  struct scoutfs_block_writer *wri,
+			  struct scoutfs_data_alloc *dalloc, u64 blkno,
+			  u64 count);
 int scoutfs_alloc_data(struct super_block *sb, struct scoutfs_alloc *alloc,
 		       struct scoutfs_block_writer *wri,
 		       struct scoutfs_data_alloc *dalloc, u64 count,
 		       u64 *blkno_ret, u64 *count_ret);
+int scoutfs_alloc_data_at(struct super_block *sb, struct scoutfs_alloc *alloc,
+			  struct scoutfs_block_writer *wri,
+			  struct scoutfs_data_alloc *dalloc, u64 blkno,
+			  u64 count, u64 *count_ret);
 int scoutfs_free_data(struct super_block *sb, struct scoutfs_alloc *alloc,
 		      struct scoutfs_block_writer *wri,
 		      struct scoutfs_alloc_root *root, u64 blkno, u64 count);
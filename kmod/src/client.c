@@ -52,6 +52,7 @@ struct client_info {
 	unsigned long connect_delay_jiffies;
 
 	u64 server_term;
+	bool server_lock_batch;
 
 	bool sending_farewell;
 	int farewell_error;
@@ -158,6 +159,58 @@ int scoutfs_client_lock_request(struct super_block *sb,
 					  client_lock_response, NULL, NULL);
 }
 
+static int client_lock_batch_response(struct super_block *sb,
+				      struct scoutfs_net_connection *conn,
+				      void *resp, unsigned int resp_len,
+				      int error, void *data)
+{
+	struct scoutfs_net_lock_batch *nlb = data;
+	struct scoutfs_net_lock_batch *rsp = resp;
+	int ret;
+
+	if (error == 0 &&
+	    (resp_len < sizeof(*rsp) || le16_to_cpu(rsp->nr) != le16_to_cpu(nlb->nr) ||
+	     resp_len != offsetof(struct scoutfs_net_lock_batch, locks[le16_to_cpu(rsp->nr)])))
+		error = -EINVAL;
+
+	ret = scoutfs_lock_batch_response(sb, nlb, error ? NULL : rsp);
+	kfree(nlb);
+	return ret;
+}
+
+/*
+ * Older servers don't know the batch command and would disconnect us.
+ * Their greeting responses don't set the flag so callers only send
+ * single lock requests.
+ */
+bool scoutfs_client_lock_batch_supported(struct super_block *sb)
+{
+	struct client_info *client = SCOUTFS_SB(sb)->client_info;
+
+	return READ_ONCE(client->server_lock_batch);
+}
+
+/*
+ * Send a batch of lock requests to the server.  The response is
+ * processed in the same synchronous receive path as single grants.
+ * The caller's batch is freed once the response is processed.
+ */
+int scoutfs_client_lock_batch_request(struct super_block *sb,
+				      struct scoutfs_net_lock_batch *nlb)
+{
+	struct client_info *client = SCOUTFS_SB(sb)->client_info;
+	u16 bytes = offsetof(struct scoutfs_net_lock_batch,
+			     locks[le16_to_cpu(nlb->nr)]);
+
+	if (!scoutfs_client_lock_batch_supported(sb))
+		return -EOPNOTSUPP;
+
+	return scoutfs_net_submit_request(sb, client->conn,
+					  SCOUTFS_NET_CMD_LOCK_BATCH,
+					  nlb, bytes,
+					  client_lock_batch_response, nlb, NULL);
+}
+
 /* Send a lock response to the server. */
 int scoutfs_client_lock_response(struct super_block *sb, u64 net_id,
 				struct scoutfs_net_lock *nl)
@@ -384,6 +437,9 @@ static int client_greeting(struct super_block *sb,
 		goto out;
 	}
 
+	WRITE_ONCE(client->server_lock_batch,
+		   !!(gr->flags & cpu_to_le64(SCOUTFS_NET_GREETING_FLAG_LOCK_BATCH)));
+
 	new_server = le64_to_cpu(gr->server_term) != client->server_term;
 	scoutfs_net_client_greeting(sb, conn, new_server);
 
@@ -13,6 +13,9 @@ u64 *scoutfs_client_bulk_alloc(struct super_block *sb);
 int scoutfs_client_get_last_seq(struct super_block *sb, u64 *seq);
 int scoutfs_client_lock_request(struct super_block *sb,
 				struct scoutfs_net_lock *nl);
+bool scoutfs_client_lock_batch_supported(struct super_block *sb);
+int scoutfs_client_lock_batch_request(struct super_block *sb,
+				      struct scoutfs_net_lock_batch *nlb);
 int scoutfs_client_lock_response(struct super_block *sb, u64 net_id,
 				struct scoutfs_net_lock *nl);
 int scoutfs_client_lock_recover_response(struct super_block *sb, u64 net_id,
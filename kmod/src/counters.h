@@ -13,6 +13,7 @@
  */
 #define EXPAND_EACH_COUNTER					\
 	EXPAND_COUNTER(alloc_alloc_data)			\
+	EXPAND_COUNTER(alloc_alloc_data_at)			\
 	EXPAND_COUNTER(alloc_alloc_meta)			\
 	EXPAND_COUNTER(alloc_free_data)				\
 	EXPAND_COUNTER(alloc_free_meta)				\
@@ -73,14 +74,28 @@
 	EXPAND_COUNTER(corrupt_symlink_inode_size)		\
 	EXPAND_COUNTER(corrupt_symlink_missing_item)		\
 	EXPAND_COUNTER(corrupt_symlink_not_null_term)		\
+	EXPAND_COUNTER(data_alloc_write_extent)			\
+	EXPAND_COUNTER(data_direct_read)			\
+	EXPAND_COUNTER(data_direct_write)			\
+	EXPAND_COUNTER(data_direct_write_enobufs_retry)		\
 	EXPAND_COUNTER(data_fallocate_enobufs_retry)		\
+	EXPAND_COUNTER(data_get_block_ext_cached)		\
+	EXPAND_COUNTER(data_stage_splice_bytes)			\
+	EXPAND_COUNTER(data_stream_alloc_cursor)		\
+	EXPAND_COUNTER(data_stream_alloc_new)			\
+	EXPAND_COUNTER(data_stream_alloc_resv)			\
+	EXPAND_COUNTER(data_waiting_events_overflow)		\
 	EXPAND_COUNTER(data_write_begin_enobufs_retry)		\
+	EXPAND_COUNTER(dentry_revalidate_dirent)		\
 	EXPAND_COUNTER(dentry_revalidate_error)			\
 	EXPAND_COUNTER(dentry_revalidate_invalid)		\
 	EXPAND_COUNTER(dentry_revalidate_rcu)			\
 	EXPAND_COUNTER(dentry_revalidate_root)			\
 	EXPAND_COUNTER(dentry_revalidate_valid)			\
 	EXPAND_COUNTER(dir_backref_excessive_retries)		\
+	EXPAND_COUNTER(dir_index_build)				\
+	EXPAND_COUNTER(dir_index_drop)				\
+	EXPAND_COUNTER(dir_index_hit)				\
 	EXPAND_COUNTER(ext_op_insert)				\
 	EXPAND_COUNTER(ext_op_next)				\
 	EXPAND_COUNTER(ext_op_remove)				\
@@ -90,6 +105,13 @@
 	EXPAND_COUNTER(forest_read_items)			\
 	EXPAND_COUNTER(forest_roots_next_hint)			\
 	EXPAND_COUNTER(forest_set_bloom_bits)			\
+	EXPAND_COUNTER(inode_delete_deferred)			\
+	EXPAND_COUNTER(inode_delete_deferred_error)		\
+	EXPAND_COUNTER(inode_deleted)				\
+	EXPAND_COUNTER(ioctl_get_inode_attrs_ents)		\
+	EXPAND_COUNTER(ioctl_readdir_plus_ents)			\
+	EXPAND_COUNTER(ioctl_release_batch_ents)		\
+	EXPAND_COUNTER(ioctl_stage_batch_ents)			\
 	EXPAND_COUNTER(item_cache_count_objects)		\
 	EXPAND_COUNTER(item_cache_scan_objects)			\
 	EXPAND_COUNTER(item_clear_dirty)			\
@@ -125,11 +147,15 @@
 	EXPAND_COUNTER(item_update)				\
 	EXPAND_COUNTER(item_write_dirty)			\
 	EXPAND_COUNTER(lock_alloc)				\
+	EXPAND_COUNTER(lock_batch_denied)			\
+	EXPAND_COUNTER(lock_batch_granted)			\
+	EXPAND_COUNTER(lock_batch_request)			\
 	EXPAND_COUNTER(lock_count_objects)			\
 	EXPAND_COUNTER(lock_free)				\
 	EXPAND_COUNTER(lock_grant_request)			\
 	EXPAND_COUNTER(lock_grant_response)			\
 	EXPAND_COUNTER(lock_invalidate_coverage)		\
+	EXPAND_COUNTER(lock_invalidate_held)			\
 	EXPAND_COUNTER(lock_invalidate_inode)			\
 	EXPAND_COUNTER(lock_invalidate_request)			\
 	EXPAND_COUNTER(lock_invalidate_response)		\
@@ -138,8 +164,16 @@
 	EXPAND_COUNTER(lock_lock)				\
 	EXPAND_COUNTER(lock_lock_error)				\
 	EXPAND_COUNTER(lock_nonblock_eagain)			\
+	EXPAND_COUNTER(lock_prefetch)				\
 	EXPAND_COUNTER(lock_recover_request)			\
+	EXPAND_COUNTER(lock_retain)				\
+	EXPAND_COUNTER(lock_retain_items_dropped)		\
+	EXPAND_COUNTER(lock_retain_items_kept)			\
 	EXPAND_COUNTER(lock_scan_objects)			\
+	EXPAND_COUNTER(lock_server_batch_denied)		\
+	EXPAND_COUNTER(lock_server_batch_granted)		\
+	EXPAND_COUNTER(lock_server_mutex_contended)		\
+	EXPAND_COUNTER(lock_server_shard_contended)		\
 	EXPAND_COUNTER(lock_shrink_attempted)			\
 	EXPAND_COUNTER(lock_shrink_aborted)			\
 	EXPAND_COUNTER(lock_shrink_work)			\
@@ -149,11 +183,13 @@
 	EXPAND_COUNTER(net_send_bytes)				\
 	EXPAND_COUNTER(net_send_error)				\
 	EXPAND_COUNTER(net_send_messages)			\
+	EXPAND_COUNTER(net_send_sendmsg)			\
 	EXPAND_COUNTER(net_recv_bytes)				\
 	EXPAND_COUNTER(net_recv_dropped_duplicate)		\
 	EXPAND_COUNTER(net_recv_error)				\
 	EXPAND_COUNTER(net_recv_invalid_message)		\
 	EXPAND_COUNTER(net_recv_messages)			\
+	EXPAND_COUNTER(net_recv_recvmsg)			\
 	EXPAND_COUNTER(net_unknown_request)			\
 	EXPAND_COUNTER(orphan_scan)				\
 	EXPAND_COUNTER(orphan_scan_attempts)			\
@@ -178,9 +214,15 @@
 	EXPAND_COUNTER(quorum_send_vote)			\
 	EXPAND_COUNTER(quorum_server_shutdown)			\
 	EXPAND_COUNTER(quorum_term_follower)			\
+	EXPAND_COUNTER(server_client_data_consumed)		\
+	EXPAND_COUNTER(server_client_meta_consumed)		\
+	EXPAND_COUNTER(server_commit_group_holders)		\
+	EXPAND_COUNTER(server_commit_group_join)		\
 	EXPAND_COUNTER(server_commit_hold)			\
+	EXPAND_COUNTER(server_commit_hold_stall)		\
 	EXPAND_COUNTER(server_commit_queue)			\
 	EXPAND_COUNTER(server_commit_worker)			\
+	EXPAND_COUNTER(server_data_fill_boosted)		\
 	EXPAND_COUNTER(srch_add_entry)				\
 	EXPAND_COUNTER(srch_compact_dirty_block)		\
 	EXPAND_COUNTER(srch_compact_entry)			\
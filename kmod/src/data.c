@@ -21,6 +21,10 @@
 #include <linux/log2.h>
 #include <linux/falloc.h>
 #include <linux/writeback.h>
+#include <linux/splice.h>
+#include <linux/highmem.h>
+#include <linux/anon_inodes.h>
+#include <linux/poll.h>
 
 #include "format.h"
 #include "super.h"
@@ -48,6 +52,28 @@
  */
 #define EXTENTS_PER_HOLD 8
 
+/*
+ * We track a small number of recent allocating inodes as streams so
+ * that concurrent streaming writers each get their own contiguous
+ * region of the device instead of interleaving their allocations.
+ * Stream reservations are only held in memory so up to NR * RESV_MAX
+ * blocks can be missing from statfs free space until the next commit
+ * returns them.
+ */
+#define DATA_STREAMS_NR 16
+#define DATA_STREAM_MIN_RUN SCOUTFS_ALLOC_DATA_LG_THRESH
+#define DATA_STREAM_RESV_MAX \
+	(64ULL * 1024 * 1024 >> SCOUTFS_BLOCK_SM_SHIFT)
+
+struct data_stream {
+	struct list_head head;
+	u64 ino;
+	u64 iblock;
+	u64 blkno;
+	u64 resv;
+	u64 run;
+};
+
 struct data_info {
 	struct super_block *sb;
 	struct mutex mutex;
@@ -55,6 +81,8 @@ struct data_info {
 	struct scoutfs_block_writer *wri;
 	struct scoutfs_alloc_root data_freed;
 	struct scoutfs_data_alloc dalloc;
+	struct list_head stream_lru;
+	struct data_stream streams[DATA_STREAMS_NR];
 };
 
 #define DECLARE_DATA_INFO(sb, name) \
@@ -92,6 +120,56 @@ static void ext_from_item(struct scoutfs_extent *ext,
 	ext->flags = dv->flags;
 }
 
+static inline u64 ext_last(struct scoutfs_extent *ext)
+{
+	return ext->start + ext->len - 1;
+}
+
+/*
+ * get_block is called for each block written and for each readahead
+ * window, and each call would otherwise search the extent items.  We
+ * cache the last extent that was found in the inode.  It's only used
+ * while the same grant of the inode's lock is held, and all extent item
+ * modifications clear it.  Callers hold extent_sem.
+ */
+static bool ext_cache_get(struct inode *inode, struct scoutfs_lock *lock,
+			  u64 iblock, struct scoutfs_extent *ext)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+	bool found = false;
+
+	spin_lock(&si->ext_cache_lock);
+	if (si->ext_cache_gen == lock->refresh_gen &&
+	    iblock >= si->ext_cache.start &&
+	    iblock <= ext_last(&si->ext_cache)) {
+		*ext = si->ext_cache;
+		found = true;
+	}
+	spin_unlock(&si->ext_cache_lock);
+
+	return found;
+}
+
+static void ext_cache_set(struct inode *inode, struct scoutfs_lock *lock,
+			  struct scoutfs_extent *ext)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+
+	spin_lock(&si->ext_cache_lock);
+	si->ext_cache = *ext;
+	si->ext_cache_gen = lock->refresh_gen;
+	spin_unlock(&si->ext_cache_lock);
+}
+
+static void ext_cache_clear(struct inode *inode)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+
+	spin_lock(&si->ext_cache_lock);
+	si->ext_cache_gen = 0;
+	spin_unlock(&si->ext_cache_lock);
+}
+
 static void data_ext_op_warn(struct inode *inode)
 {
 	struct scoutfs_inode_info *si;
@@ -151,6 +229,8 @@ static int data_ext_insert(struct super_block *sb, void *arg, u64 start,
 	int ret;
 
 	data_ext_op_warn(args->inode);
+	if (args->inode)
+		ext_cache_clear(args->inode);
 
 	item_from_extent(&key, &dv, args->ino, start, len, map, flags);
 	ret = scoutfs_item_create(sb, &key, &dv, sizeof(dv), args->lock);
@@ -168,6 +248,8 @@ static int data_ext_remove(struct super_block *sb, void *arg, u64 start,
 	int ret;
 
 	data_ext_op_warn(args->inode);
+	if (args->inode)
+		ext_cache_clear(args->inode);
 
 	item_from_extent(&key, &dv, args->ino, start, len, map, flags);
 	ret = scoutfs_item_delete(sb, &key, args->lock);
@@ -359,9 +441,164 @@ int scoutfs_data_truncate_items(struct super_block *sb, struct inode *inode,
 	return ret;
 }
 
-static inline u64 ext_last(struct scoutfs_extent *ext)
+/*
+ * Each stream is a cursor that records the next logical block that a
+ * streaming writer will allocate and the physical block that would
+ * continue its previous allocation.  Streams can also hold a
+ * reservation of free blocks following the cursor's blkno that were
+ * allocated but not yet used.  Reservations are only held in memory
+ * and are returned to the allocator before each commit.
+ */
+static int return_stream_resv(struct super_block *sb,
+			      struct data_info *datinf,
+			      struct data_stream *st)
 {
-	return ext->start + ext->len - 1;
+	int ret = 0;
+
+	if (st->resv) {
+		ret = scoutfs_dalloc_return(sb, datinf->alloc, datinf->wri,
+					    &datinf->dalloc, st->blkno,
+					    st->resv);
+		if (ret == 0)
+			st->resv = 0;
+	}
+
+	return ret;
+}
+
+static int return_all_stream_resv(struct super_block *sb,
+				  struct data_info *datinf, bool *returned)
+{
+	struct data_stream *st;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < DATA_STREAMS_NR; i++) {
+		st = &datinf->streams[i];
+		if (st->resv) {
+			ret = return_stream_resv(sb, datinf, st);
+			if (ret < 0)
+				break;
+			if (returned)
+				*returned = true;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Find the stream for an inode that's allocating at the given logical
+ * block, reusing the least recently used stream if the inode doesn't
+ * have one.  A stream that isn't continuing from its cursor is no
+ * longer streaming and is reset.
+ */
+static int get_stream(struct super_block *sb, struct data_info *datinf,
+		      u64 ino, u64 iblock, struct data_stream **st_ret)
+{
+	struct data_stream *st;
+	int ret;
+
+	list_for_each_entry(st, &datinf->stream_lru, head) {
+		if (st->ino == ino)
+			goto found;
+	}
+
+	st = list_last_entry(&datinf->stream_lru, struct data_stream, head);
+	st->ino = ino;
+	st->iblock = U64_MAX;
+found:
+	if (st->iblock != iblock) {
+		ret = return_stream_resv(sb, datinf, st);
+		if (ret < 0)
+			return ret;
+		st->iblock = iblock;
+		st->blkno = 0;
+		st->run = 0;
+	}
+
+	list_move(&st->head, &datinf->stream_lru);
+	*st_ret = st;
+	return 0;
+}
+
+/*
+ * Allocate count blocks for the stream.  We first use its reservation,
+ * then try to continue from the end of its previous allocation, and
+ * finally allocate a new run that also reserves blocks in proportion
+ * to how long the stream has been writing sequentially.
+ *
+ * Streams that haven't written much are allocated like any other
+ * allocation.  Small files are packed together from the cached extent
+ * and preallocation already sizes their extents.
+ *
+ * The stream's blkno cursor is advanced past the returned allocation.
+ * The caller advances the logical cursor once it has used the blocks.
+ */
+static int stream_alloc(struct super_block *sb, struct data_info *datinf,
+			struct data_stream *st, u64 count, u64 *blkno_ret,
+			u64 *count_ret)
+{
+	bool returned = false;
+	u64 extra;
+	u64 blkno;
+	u64 len;
+	int ret;
+
+	if (st->resv) {
+		len = min(count, st->resv);
+		blkno = st->blkno;
+		st->resv -= len;
+		scoutfs_inc_counter(sb, data_stream_alloc_resv);
+		ret = 0;
+		goto out;
+	}
+
+	extra = 0;
+	if (st->run >= DATA_STREAM_MIN_RUN) {
+		if (st->blkno) {
+			ret = scoutfs_alloc_data_at(sb, datinf->alloc,
+						    datinf->wri,
+						    &datinf->dalloc,
+						    st->blkno, count, &len);
+			if (ret == 0) {
+				blkno = st->blkno;
+				scoutfs_inc_counter(sb, data_stream_alloc_cursor);
+				goto out;
+			}
+			if (ret != -ENOENT)
+				goto out;
+		}
+
+		extra = min_t(u64, st->run, DATA_STREAM_RESV_MAX);
+	}
+retry:
+	ret = scoutfs_alloc_data(sb, datinf->alloc, datinf->wri,
+				 &datinf->dalloc, count + extra, &blkno, &len);
+	if (ret == -ENOSPC && !returned) {
+		/* other streams' reservations could satisfy us */
+		ret = return_all_stream_resv(sb, datinf, &returned);
+		if (ret == 0 && returned)
+			goto retry;
+		if (ret == 0)
+			ret = -ENOSPC;
+	}
+	if (ret < 0)
+		goto out;
+
+	if (extra)
+		scoutfs_inc_counter(sb, data_stream_alloc_new);
+	if (len > count) {
+		st->resv = len - count;
+		len = count;
+	}
+out:
+	if (ret == 0) {
+		st->blkno = blkno + len;
+		*blkno_ret = blkno;
+		*count_ret = len;
+	}
+	return ret;
 }
 
 /*
@@ -380,12 +617,20 @@ static inline u64 ext_last(struct scoutfs_extent *ext)
  * This can waste a lot of space for small or sparse files but is
  * reasonable when a file population is known to be large and dense but
  * known to be written with non-streaming write patterns.
+ *
+ * Allocations are made through the inode's stream so that files
+ * written sequentially, including archived files being staged, are
+ * laid out sequentially on the device.
+ *
+ * Direct writers ask for iblock to be left unwritten so that it isn't
+ * exposed until their IO has completed.
  */
 static int alloc_block(struct super_block *sb, struct inode *inode,
 		       struct scoutfs_extent *ext, u64 iblock,
-		       struct scoutfs_lock *lock)
+		       bool unwritten, struct scoutfs_lock *lock)
 {
 	DECLARE_DATA_INFO(sb, datinf);
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
 	struct scoutfs_mount_options opts;
 	const u64 ino = scoutfs_ino(inode);
 	struct data_ext_args args = {
@@ -395,6 +640,7 @@ static int alloc_block(struct super_block *sb, struct inode *inode,
 	};
 	struct scoutfs_extent found;
 	struct scoutfs_extent pre = {0,};
+	struct data_stream *st = NULL;
 	bool undo_pre = false;
 	u64 blkno = 0;
 	u64 online;
@@ -402,6 +648,7 @@ static int alloc_block(struct super_block *sb, struct inode *inode,
 	u8 flags;
 	u64 start;
 	u64 count;
+	u64 want;
 	u64 rem;
 	int ret;
 	int err;
@@ -484,11 +731,33 @@ static int alloc_block(struct super_block *sb, struct inode *inode,
 			count = (found.start - start);
 	}
 
+	/*
+	 * Buffered writes allocate a block at a time as each page is
+	 * dirtied.  We know the extent of the caller's whole write so
+	 * we allocate enough to cover the rest of it with its first
+	 * block, up to the next existing extent.  The remaining blocks
+	 * are unwritten until each page is written.
+	 */
+	if (!ext->len && start == iblock && si->write_end > iblock + count) {
+		ret = scoutfs_ext_next(sb, &data_ext_ops, &args, iblock, 1,
+				       &found);
+		if (ret < 0 && ret != -ENOENT)
+			goto out;
+		if (found.len && found.start > iblock)
+			want = min(si->write_end, found.start) - iblock;
+		else
+			want = si->write_end - iblock;
+		if (want > count) {
+			count = want;
+			scoutfs_inc_counter(sb, data_alloc_write_extent);
+		}
+	}
+
 	/* overall prealloc limit */
 	count = min_t(u64, count, opts.data_prealloc_blocks);
 
-	ret = scoutfs_alloc_data(sb, datinf->alloc, datinf->wri,
-				 &datinf->dalloc, count, &blkno, &count);
+	ret = get_stream(sb, datinf, ino, start, &st) ?:
+	      stream_alloc(sb, datinf, st, count, &blkno, &count);
 	if (ret < 0)
 		goto out;
 
@@ -513,7 +782,8 @@ static int alloc_block(struct super_block *sb, struct inode *inode,
 		undo_pre = true;
 	}
 
-	ret = scoutfs_ext_set(sb, &data_ext_ops, &args, iblock, 1, blkno + (iblock - start), 0);
+	ret = scoutfs_ext_set(sb, &data_ext_ops, &args, iblock, 1, blkno + (iblock - start),
+			      unwritten ? SEF_UNWRITTEN : 0);
 	if (ret < 0)
 		goto out;
 
@@ -521,7 +791,7 @@ static int alloc_block(struct super_block *sb, struct inode *inode,
 	ext->start = iblock;
 	ext->len = 1;
 	ext->map = blkno + (iblock - start);
-	ext->flags = 0;
+	ext->flags = unwritten ? SEF_UNWRITTEN : 0;
 	ret = 0;
 out:
 	if (ret < 0 && blkno > 0) {
@@ -536,6 +806,8 @@ out:
 	}
 
 	if (ret == 0) {
+		st->iblock = start + count;
+		st->run += count;
 		trace_scoutfs_data_alloc(sb, ino, ext);
 		trace_scoutfs_data_prealloc(sb, ino, &pre);
 	}
@@ -545,8 +817,13 @@ out:
 	return ret;
 }
 
+/*
+ * Direct writes map unwritten extents without converting them.  The
+ * caller converts the extents once the blocks have been written so that
+ * failed writes can't expose stale block contents.
+ */
 static int scoutfs_get_block(struct inode *inode, sector_t iblock,
-			     struct buffer_head *bh, int create)
+			     struct buffer_head *bh, int create, bool direct)
 {
 	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
 	const u64 ino = scoutfs_ino(inode);
@@ -571,11 +848,18 @@ static int scoutfs_get_block(struct inode *inode, sector_t iblock,
 	args.inode = inode;
 	args.lock = lock;
 
-	ret = scoutfs_ext_next(sb, &data_ext_ops, &args, iblock, 1, &ext);
-	if (ret == -ENOENT || (ret == 0 && ext.start > iblock))
-		memset(&ext, 0, sizeof(ext));
-	else if (ret < 0)
-		goto out;
+	if (ext_cache_get(inode, lock, iblock, &ext)) {
+		scoutfs_inc_counter(sb, data_get_block_ext_cached);
+		ret = 0;
+	} else {
+		ret = scoutfs_ext_next(sb, &data_ext_ops, &args, iblock, 1, &ext);
+		if (ret == -ENOENT || (ret == 0 && ext.start > iblock))
+			memset(&ext, 0, sizeof(ext));
+		else if (ret < 0)
+			goto out;
+		else
+			ext_cache_set(inode, lock, &ext);
+	}
 
 	if (ext.len)
 		trace_scoutfs_data_get_block_found(sb, ino, &ext);
@@ -586,6 +870,13 @@ static int scoutfs_get_block(struct inode *inode, sector_t iblock,
 		goto out;
 	}
 
+	/* direct writers convert unwritten extents after their IO */
+	if (create && direct && ext.map && (ext.flags & SEF_UNWRITTEN)) {
+		set_buffer_new(bh);
+		ret = 0;
+		goto out;
+	}
+
 	/* convert unwritten to written, could be staging */
 	if (create && ext.map && (ext.flags & SEF_UNWRITTEN)) {
 		un.start = iblock;
@@ -603,7 +894,7 @@ static int scoutfs_get_block(struct inode *inode, sector_t iblock,
 
 	/* allocate and map blocks containing our logical block */
 	if (create && !ext.map) {
-		ret = alloc_block(sb, inode, &ext, iblock, lock);
+		ret = alloc_block(sb, inode, &ext, iblock, direct, lock);
 		if (ret == 0)
 			set_buffer_new(bh);
 	} else {
@@ -611,7 +902,8 @@ static int scoutfs_get_block(struct inode *inode, sector_t iblock,
 	}
 out:
 	/* map usable extent, else leave bh unmapped for sparse reads */
-	if (ret == 0 && ext.map && !(ext.flags & SEF_UNWRITTEN)) {
+	if (ret == 0 && ext.map &&
+	    (!(ext.flags & SEF_UNWRITTEN) || (create && direct))) {
 		offset = iblock - ext.start;
 		map_bh(bh, inode->i_sb, ext.map + offset);
 		bh->b_size = min_t(u64, bh->b_size,
@@ -637,7 +929,7 @@ static int scoutfs_get_block_read(struct inode *inode, sector_t iblock,
 	int ret;
 
 	down_read(&si->extent_sem);
-	ret = scoutfs_get_block(inode, iblock, bh, create);
+	ret = scoutfs_get_block(inode, iblock, bh, create, false);
 	up_read(&si->extent_sem);
 
 	return ret;
@@ -650,12 +942,78 @@ int scoutfs_get_block_write(struct inode *inode, sector_t iblock, struct buffer_
 	int ret;
 
 	down_write(&si->extent_sem);
-	ret = scoutfs_get_block(inode, iblock, bh, create);
+	ret = scoutfs_get_block(inode, iblock, bh, create, false);
+	up_write(&si->extent_sem);
+
+	return ret;
+}
+
+#ifndef KC_LINUX_HAVE_FOP_AIO_READ
+static int scoutfs_get_block_direct_write(struct inode *inode, sector_t iblock,
+					  struct buffer_head *bh, int create)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+	int ret;
+
+	down_write(&si->extent_sem);
+	ret = scoutfs_get_block(inode, iblock, bh, create, true);
 	up_write(&si->extent_sem);
 
 	return ret;
 }
 
+/*
+ * Convert the unwritten extents in the range of blocks that a direct
+ * write has finished writing.  Partial blocks at the edges of the write
+ * were zeroed by the direct IO paths because their buffers were new.
+ */
+static int convert_direct_unwritten(struct inode *inode, struct scoutfs_lock *lock,
+				    u64 iblock, u64 last)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+	struct super_block *sb = inode->i_sb;
+	struct data_ext_args args = {
+		.ino = scoutfs_ino(inode),
+		.inode = inode,
+		.lock = lock,
+	};
+	struct scoutfs_extent ext;
+	u64 start;
+	u64 len;
+	int ret = 0;
+
+	down_write(&si->extent_sem);
+
+	while (iblock <= last) {
+		ret = scoutfs_ext_next(sb, &data_ext_ops, &args, iblock, 1, &ext);
+		if (ret < 0) {
+			if (ret == -ENOENT)
+				ret = 0;
+			break;
+		}
+		if (ext.start > last)
+			break;
+
+		start = max(iblock, ext.start);
+		len = min(last, ext_last(&ext)) - start + 1;
+
+		if (ext.map && (ext.flags & SEF_UNWRITTEN)) {
+			ret = scoutfs_ext_set(sb, &data_ext_ops, &args, start, len,
+					      ext.map + (start - ext.start),
+					      ext.flags & ~(SEF_OFFLINE | SEF_UNWRITTEN));
+			if (ret < 0)
+				break;
+		}
+
+		iblock = start + len;
+	}
+
+	up_write(&si->extent_sem);
+
+	return ret;
+}
+#endif
+
 /*
  * This is almost never used.  We can't block on a cluster lock while
  * holding the page lock because lock invalidation gets the page lock
@@ -811,6 +1169,109 @@ static int scoutfs_writepages(struct address_space *mapping,
 	return mpage_writepages(mapping, wbc, scoutfs_get_block_write);
 }
 
+#ifndef KC_LINUX_HAVE_FOP_AIO_READ
+/*
+ * Direct IO maps extents with get_block and submits bios straight to
+ * the data device.  Reads are protected from release by the caller's
+ * i_dio_count and have already waited for offline extents.
+ *
+ * Writes allocate unwritten extents and only convert them to written
+ * once the chunk's IO has completed.  The extent items can't be
+ * committed before the blocks they reference are written so we hold a
+ * transaction across each chunk of the write and wait for its IO before
+ * releasing it.  A failed write leaves its blocks unwritten.  Async
+ * callers return 0 which has the generic paths fall back to buffered
+ * IO.  Like other get_block filesystems, holes inside i_size aren't
+ * allocated and the generic paths fall back to buffered writes for
+ * them.
+ */
+#define DIRECT_WRITE_CHUNK_BYTES (8 * 1024 * 1024)
+
+static ssize_t scoutfs_direct_IO(struct kiocb *iocb, struct iov_iter *iter)
+{
+	struct inode *inode = file_inode(iocb->ki_filp);
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+	struct super_block *sb = inode->i_sb;
+	struct scoutfs_lock *lock;
+	const loff_t pos = iocb->ki_pos;
+	LIST_HEAD(ind_locks);
+	ssize_t written = 0;
+	ssize_t ret = 0;
+	size_t chunk;
+	size_t rem;
+	int err;
+
+	if (!is_sync_kiocb(iocb))
+		return 0;
+
+	if (iov_iter_rw(iter) == READ) {
+		scoutfs_inc_counter(sb, data_direct_read);
+		return blockdev_direct_IO(iocb, inode, iter,
+					  scoutfs_get_block_read);
+	}
+
+	lock = scoutfs_per_task_get(&si->pt_data_lock);
+	if (WARN_ON_ONCE(!lock))
+		return -EINVAL;
+
+	scoutfs_inc_counter(sb, data_direct_write);
+
+	while (iov_iter_count(iter) > 0) {
+		chunk = min_t(size_t, iov_iter_count(iter),
+			      DIRECT_WRITE_CHUNK_BYTES);
+		rem = iov_iter_count(iter) - chunk;
+		iov_iter_truncate(iter, chunk);
+
+		ret = scoutfs_inode_index_lock_hold(inode, &ind_locks, true,
+						    true);
+		if (ret == 0) {
+			iocb->ki_pos = pos + written;
+			ret = blockdev_direct_IO(iocb, inode, iter,
+						 scoutfs_get_block_direct_write);
+			if (ret > 0) {
+				err = convert_direct_unwritten(inode, lock,
+						iocb->ki_pos >> SCOUTFS_BLOCK_SM_SHIFT,
+						(iocb->ki_pos + ret - 1) >> SCOUTFS_BLOCK_SM_SHIFT);
+				if (err < 0)
+					ret = err;
+			}
+			if (ret > 0) {
+				if (iocb->ki_pos + ret > i_size_read(inode))
+					i_size_write(inode, iocb->ki_pos + ret);
+				scoutfs_inode_set_data_seq(inode);
+				scoutfs_inode_inc_data_version(inode);
+				inode_inc_iversion(inode);
+				scoutfs_update_inode_item(inode, lock,
+							  &ind_locks);
+			}
+			scoutfs_release_trans(sb);
+			scoutfs_inode_index_unlock(sb, &ind_locks);
+		}
+
+		/* errors don't return the bytes that the iter was advanced by */
+		if (ret < 0)
+			iov_iter_revert(iter, chunk - iov_iter_count(iter));
+		iov_iter_reexpand(iter, iov_iter_count(iter) + rem);
+
+		/* txn couldn't meet the request, try with a new txn */
+		if (ret == -ENOBUFS) {
+			scoutfs_inc_counter(sb, data_direct_write_enobufs_retry);
+			continue;
+		}
+
+		if (ret <= 0)
+			break;
+
+		written += ret;
+		if (ret < chunk)
+			break;
+	}
+
+	iocb->ki_pos = pos;
+	return written ? written : ret;
+}
+#endif
+
 /* fsdata allocated in write_begin and freed in write_end */
 struct write_begin_data {
 	struct list_head ind_locks;
@@ -942,6 +1403,84 @@ static int scoutfs_write_end(struct file *file, struct address_space *mapping,
 	return ret;
 }
 
+/*
+ * Copy a spliced source page into our page cache through the usual
+ * write_begin and write_end, a lot like the old generic pipe_to_file.
+ * The pipe buffers have already been confirmed by splice_from_pipe.
+ * Like buffered writes we throttle dirtying and stop for fatal signals.
+ */
+static int stage_pipe_buf(struct pipe_inode_info *pipe,
+			  struct pipe_buffer *buf, struct splice_desc *sd)
+{
+	struct file *file = sd->u.file;
+	struct address_space *mapping = file->f_mapping;
+	unsigned int offset = sd->pos & ~PAGE_MASK;
+	unsigned int len = min_t(unsigned int, sd->len, PAGE_SIZE - offset);
+	struct page *page;
+	void *fsdata;
+	char *src;
+	char *dst;
+	int ret;
+
+	if (fatal_signal_pending(current))
+		return -EINTR;
+
+	ret = scoutfs_write_begin(file, mapping, sd->pos, len, 0, &page,
+				  &fsdata);
+	if (ret)
+		return ret;
+
+	src = kmap_atomic(buf->page);
+	dst = kmap_atomic(page);
+	memcpy(dst + offset, src + buf->offset, len);
+	flush_dcache_page(page);
+	kunmap_atomic(dst);
+	kunmap_atomic(src);
+
+	ret = scoutfs_write_end(file, mapping, sd->pos, len, len, page,
+				fsdata);
+	if (ret > 0)
+		balance_dirty_pages_ratelimited(mapping);
+
+	return ret;
+}
+
+static int stage_splice_actor(struct pipe_inode_info *pipe,
+			      struct splice_desc *sd)
+{
+	return splice_from_pipe(pipe, sd->u.file, sd->opos, sd->total_len,
+				sd->flags, stage_pipe_buf);
+}
+
+/*
+ * Stage file contents from the page cache of a source file.  The
+ * source pages are spliced into an internal pipe and each is copied
+ * once into our page cache with write_begin and write_end, which see
+ * the staging flag on the inode and convert the offline extents.  The
+ * caller holds i_mutex and the cluster lock and has done all the
+ * staging checks.
+ */
+ssize_t scoutfs_data_stage_splice(struct file *file, loff_t offset,
+				  loff_t len, struct file *src, loff_t src_off)
+{
+	struct super_block *sb = file_inode(file)->i_sb;
+	loff_t pos = offset;
+	struct splice_desc sd = {
+		.total_len = len,
+		.flags = 0,
+		.pos = src_off,
+		.u.file = file,
+		.opos = &pos,
+	};
+	ssize_t ret;
+
+	ret = splice_direct_to_actor(src, &sd, stage_splice_actor);
+	if (ret > 0)
+		scoutfs_add_counter(sb, data_stage_splice_bytes, ret);
+
+	return ret;
+}
+
 /*
  * Try to allocate unwritten extents for any unallocated regions of the
  * logical block extent from the caller.  The caller manages locks and
@@ -1682,6 +2221,60 @@ static struct scoutfs_data_wait *dw_next(struct scoutfs_data_wait *dw)
 	return NULL;
 }
 
+/*
+ * Agents can get a file descriptor that delivers waiting events as
+ * tasks start waiting for offline data instead of polling the waiting
+ * ioctl.  Each listener has a fixed ring of events that is filled as
+ * waiters are inserted.  If the reader falls behind and the ring fills
+ * then new events are dropped and the next read returns -EOVERFLOW so
+ * the agent knows to fall back to iterating over all the waiters with
+ * the ioctl.
+ */
+#define DATA_WAITING_EVENTS_NR 256
+
+struct data_waiting_listener {
+	struct list_head head;
+	struct super_block *sb;
+	struct path path;
+	wait_queue_head_t waitq;
+	bool overflowed;
+	unsigned int first;
+	unsigned int nr;
+	struct scoutfs_ioctl_data_waiting_entry ents[DATA_WAITING_EVENTS_NR];
+};
+
+/*
+ * A new waiter was inserted, queue an event for all the listeners.
+ * The caller holds the root lock.
+ */
+static void queue_waiting_events(struct super_block *sb,
+				 struct scoutfs_data_wait_root *rt,
+				 struct scoutfs_data_wait *dw)
+{
+	struct data_waiting_listener *lsn;
+	struct scoutfs_ioctl_data_waiting_entry *dwe;
+
+	assert_spin_locked(&rt->lock);
+
+	list_for_each_entry(lsn, &rt->listeners, head) {
+		if (lsn->nr == DATA_WAITING_EVENTS_NR) {
+			if (!lsn->overflowed) {
+				lsn->overflowed = true;
+				scoutfs_inc_counter(sb, data_waiting_events_overflow);
+			}
+		} else {
+			dwe = &lsn->ents[(lsn->first + lsn->nr) %
+					 DATA_WAITING_EVENTS_NR];
+			memset(dwe, 0, sizeof(struct scoutfs_ioctl_data_waiting_entry));
+			dwe->ino = dw->ino;
+			dwe->iblock = dw->iblock;
+			dwe->op = dw->op;
+			lsn->nr++;
+		}
+		wake_up(&lsn->waitq);
+	}
+}
+
 /*
  * Check if we should wait by looking for extents whose flags match.
  * Returns 0 if no extents were found or any error encountered.
@@ -1761,6 +2354,7 @@ int scoutfs_data_wait_check(struct inode *inode, loff_t pos, loff_t len,
 
 				spin_lock(&rt->lock);
 				insert_offline_waiting(&rt->root, dw);
+				queue_waiting_events(sb, rt, dw);
 				spin_unlock(&rt->lock);
 			}
 
@@ -1926,6 +2520,154 @@ int scoutfs_data_waiting(struct super_block *sb, u64 ino, u64 iblock,
 	return ret;
 }
 
+static bool waiting_events_pending(struct data_waiting_listener *lsn)
+{
+	DECLARE_DATA_WAIT_ROOT(lsn->sb, rt);
+	bool pending;
+
+	spin_lock(&rt->lock);
+	pending = lsn->nr > 0 || lsn->overflowed;
+	spin_unlock(&rt->lock);
+
+	return pending;
+}
+
+static ssize_t data_waiting_events_read(struct file *file, char __user *buf,
+					size_t count, loff_t *ppos)
+{
+	struct data_waiting_listener *lsn = file->private_data;
+	DECLARE_DATA_WAIT_ROOT(lsn->sb, rt);
+	struct scoutfs_ioctl_data_waiting_entry dwe[16];
+	size_t copied = 0;
+	unsigned int nr;
+	unsigned int i;
+	ssize_t ret = 0;
+
+	if (count < sizeof(dwe[0]))
+		return -EINVAL;
+
+	while (count >= sizeof(dwe[0])) {
+		nr = min_t(size_t, count / sizeof(dwe[0]), ARRAY_SIZE(dwe));
+
+		spin_lock(&rt->lock);
+		if (lsn->overflowed && copied == 0) {
+			lsn->overflowed = false;
+			spin_unlock(&rt->lock);
+			ret = -EOVERFLOW;
+			break;
+		}
+		nr = min(nr, lsn->nr);
+		for (i = 0; i < nr; i++) {
+			dwe[i] = lsn->ents[lsn->first];
+			lsn->first = (lsn->first + 1) % DATA_WAITING_EVENTS_NR;
+			lsn->nr--;
+		}
+		spin_unlock(&rt->lock);
+
+		if (nr == 0) {
+			/* return what we have, or wait for the first events */
+			if (copied)
+				break;
+			if (file->f_flags & O_NONBLOCK) {
+				ret = -EAGAIN;
+				break;
+			}
+			ret = wait_event_interruptible(lsn->waitq,
+						waiting_events_pending(lsn));
+			if (ret < 0)
+				break;
+			continue;
+		}
+
+		if (copy_to_user(buf + copied, dwe, nr * sizeof(dwe[0]))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		copied += nr * sizeof(dwe[0]);
+		count -= nr * sizeof(dwe[0]);
+	}
+
+	return copied ?: ret;
+}
+
+static __poll_t data_waiting_events_poll(struct file *file,
+					 struct poll_table_struct *wait)
+{
+	struct data_waiting_listener *lsn = file->private_data;
+
+	poll_wait(file, &lsn->waitq, wait);
+
+	return waiting_events_pending(lsn) ? POLLIN | POLLRDNORM : 0;
+}
+
+static int data_waiting_events_release(struct inode *inode, struct file *file)
+{
+	struct data_waiting_listener *lsn = file->private_data;
+	DECLARE_DATA_WAIT_ROOT(lsn->sb, rt);
+
+	spin_lock(&rt->lock);
+	list_del_init(&lsn->head);
+	spin_unlock(&rt->lock);
+
+	path_put(&lsn->path);
+	kfree(lsn);
+
+	return 0;
+}
+
+static const struct file_operations data_waiting_events_fops = {
+	.owner		= THIS_MODULE,
+	.read		= data_waiting_events_read,
+	.poll		= data_waiting_events_poll,
+	.release	= data_waiting_events_release,
+	.llseek		= noop_llseek,
+};
+
+/*
+ * Return a new file descriptor that delivers waiting events.  Only
+ * waiters that are inserted after the listener is added generate
+ * events, callers are expected to get the descriptor and then iterate
+ * over existing waiters with the ioctl.  The listener holds a reference
+ * to the caller's path so the mount can't be unmounted while the
+ * descriptor is open.
+ */
+int scoutfs_data_waiting_events_fd(struct file *file)
+{
+	struct super_block *sb = file_inode(file)->i_sb;
+	DECLARE_DATA_WAIT_ROOT(sb, rt);
+	struct data_waiting_listener *lsn;
+	int ret;
+
+	lsn = kzalloc(sizeof(struct data_waiting_listener), GFP_KERNEL);
+	if (!lsn)
+		return -ENOMEM;
+
+	INIT_LIST_HEAD(&lsn->head);
+	lsn->sb = sb;
+	lsn->path = file->f_path;
+	path_get(&lsn->path);
+	init_waitqueue_head(&lsn->waitq);
+
+	/* add before the fd is visible and can be closed */
+	spin_lock(&rt->lock);
+	list_add_tail(&lsn->head, &rt->listeners);
+	spin_unlock(&rt->lock);
+
+	ret = anon_inode_getfd("[scoutfs_data_waiting]",
+			       &data_waiting_events_fops, lsn,
+			       O_RDONLY | O_CLOEXEC);
+	if (ret < 0) {
+		spin_lock(&rt->lock);
+		list_del_init(&lsn->head);
+		spin_unlock(&rt->lock);
+		path_put(&lsn->path);
+		kfree(lsn);
+	}
+
+	return ret;
+}
+
 const struct address_space_operations scoutfs_file_aops = {
 	.readpage		= scoutfs_readpage,
 #ifndef KC_FILE_AOPS_READAHEAD
@@ -1937,6 +2679,9 @@ const struct address_space_operations scoutfs_file_aops = {
 	.writepages		= scoutfs_writepages,
 	.write_begin		= scoutfs_write_begin,
 	.write_end		= scoutfs_write_end,
+#ifndef KC_LINUX_HAVE_FOP_AIO_READ
+	.direct_IO		= scoutfs_direct_IO,
+#endif
 };
 
 const struct file_operations scoutfs_file_fops = {
@@ -1995,7 +2740,8 @@ int scoutfs_data_prepare_commit(struct super_block *sb)
 	int ret;
 
 	mutex_lock(&datinf->mutex);
-	ret = scoutfs_dalloc_return_cached(sb, datinf->alloc, datinf->wri,
+	ret = return_all_stream_resv(sb, datinf, NULL) ?:
+	      scoutfs_dalloc_return_cached(sb, datinf->alloc, datinf->wri,
 					   &datinf->dalloc);
 	mutex_unlock(&datinf->mutex);
 
@@ -2019,6 +2765,7 @@ int scoutfs_data_setup(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
 	struct data_info *datinf;
+	int i;
 
 	datinf = kzalloc(sizeof(struct data_info), GFP_KERNEL);
 	if (!datinf)
@@ -2026,6 +2773,9 @@ int scoutfs_data_setup(struct super_block *sb)
 
 	datinf->sb = sb;
 	mutex_init(&datinf->mutex);
+	INIT_LIST_HEAD(&datinf->stream_lru);
+	for (i = 0; i < DATA_STREAMS_NR; i++)
+		list_add(&datinf->streams[i].head, &datinf->stream_lru);
 
 	sbi->data_info = datinf;
 	return 0;
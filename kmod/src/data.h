@@ -7,6 +7,7 @@ struct scoutfs_ioctl_data_waiting_entry;
 struct scoutfs_data_wait_root {
 	spinlock_t lock;
 	struct rb_root root;
+	struct list_head listeners;
 };
 
 #define DECLARE_DATA_WAIT_ROOT(sb, nm) \
@@ -57,6 +58,8 @@ int scoutfs_data_init_offline_extent(struct inode *inode, u64 size,
 int scoutfs_data_move_blocks(struct inode *from, u64 from_off,
 			     u64 byte_len, struct inode *to, u64 to_off, bool to_stage,
 			     u64 data_version);
+ssize_t scoutfs_data_stage_splice(struct file *file, loff_t offset,
+				  loff_t len, struct file *src, loff_t src_off);
 
 int scoutfs_data_wait_check(struct inode *inode, loff_t pos, loff_t len,
 			    u8 sef, u8 op, struct scoutfs_data_wait *ow,
@@ -77,6 +80,7 @@ long scoutfs_data_wait_err(struct inode *inode, u64 sblock, u64 eblock, u64 op,
 int scoutfs_data_waiting(struct super_block *sb, u64 ino, u64 iblock,
 			 struct scoutfs_ioctl_data_waiting_entry *dwe,
 			 unsigned int nr);
+int scoutfs_data_waiting_events_fd(struct file *file);
 
 void scoutfs_data_init_btrees(struct super_block *sb,
 			      struct scoutfs_alloc *alloc,
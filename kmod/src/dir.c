@@ -16,6 +16,7 @@
 #include <linux/uio.h>
 #include <linux/xattr.h>
 #include <linux/namei.h>
+#include <linux/vmalloc.h>
 
 #include "format.h"
 #include "file.h"
@@ -34,6 +35,7 @@
 #include "forest.h"
 #include "acl.h"
 #include "counters.h"
+#include "options.h"
 #include "scoutfs_trace.h"
 
 /*
@@ -237,6 +239,369 @@ static int lookup_dentry_dirent(struct super_block *sb, u64 dir_ino, struct dent
 			     dent_ret, lock);
 }
 
+/*
+ * Directories can build an in-memory index of their dirent items once
+ * they've seen enough lookups under a lock.  Lookups in hot
+ * directories can then find names without searching the item cache for
+ * each name's hash and copying out the item values.
+ *
+ * The index is only valid under the lock refresh_gen it was built
+ * under.  Lookups only hold the dir's inode lock shared on current
+ * kernels so concurrent lookups can race to use and build the index.
+ * All access to the installed index is serialized by the dir_index_lock
+ * spinlock.  Entry modification holds the dir's inode lock exclusively
+ * and keeps the index current under the dir's write lock.  Invalidating
+ * the lock frees the index along with the rest of the inode's cached
+ * state.  An index that was being built while the lock was invalidated
+ * has a stale refresh_gen and is freed the next time it's seen.
+ */
+struct scoutfs_dir_index {
+	u64 refresh_gen;
+	unsigned long nr;
+	unsigned long nr_buckets;
+	struct hlist_head *buckets;
+};
+
+struct dir_index_entry {
+	struct hlist_node head;
+	u8 name_len;
+	struct scoutfs_dirent dent;
+	/* the full name is allocated and stored in dent.name[] */
+};
+
+/* vmalloc allocates pages so always use at least a page of buckets */
+#define DIR_INDEX_MIN_BUCKETS	(PAGE_SIZE / sizeof(struct hlist_head))
+
+static struct hlist_head *dir_index_bucket(struct scoutfs_dir_index *dind, u64 hash)
+{
+	/* the low bits of the name hash are from the full name hash */
+	return &dind->buckets[hash & (dind->nr_buckets - 1)];
+}
+
+static struct dir_index_entry *alloc_dir_index_entry(struct scoutfs_dirent *dent,
+						     const char *name,
+						     unsigned int name_len)
+{
+	struct dir_index_entry *ent;
+
+	ent = kmalloc(sizeof(struct dir_index_entry) + name_len, GFP_NOFS);
+	if (ent) {
+		INIT_HLIST_NODE(&ent->head);
+		ent->name_len = name_len;
+		ent->dent = *dent;
+		memcpy(ent->dent.name, name, name_len);
+	}
+
+	return ent;
+}
+
+static void free_dir_index(struct scoutfs_dir_index *dind)
+{
+	struct dir_index_entry *ent;
+	struct hlist_node *tmp;
+	unsigned long i;
+
+	if (dind) {
+		for (i = 0; i < dind->nr_buckets; i++) {
+			hlist_for_each_entry_safe(ent, tmp, &dind->buckets[i], head)
+				kfree(ent);
+		}
+		vfree(dind->buckets);
+		kfree(dind);
+	}
+}
+
+/*
+ * Remove the dir's index if it doesn't match the caller's lock or if
+ * it's being dropped.  The caller frees the returned index after
+ * unlocking.  Dropping resets the lookup count so that the index can
+ * be built again.
+ */
+static struct scoutfs_dir_index *detach_dir_index(struct super_block *sb,
+						  struct scoutfs_inode_info *si,
+						  struct scoutfs_lock *lock, bool drop)
+{
+	struct scoutfs_dir_index *dind = si->dir_index;
+
+	assert_spin_locked(&si->dir_index_lock);
+
+	if (dind && (drop || dind->refresh_gen != lock->refresh_gen)) {
+		si->dir_index = NULL;
+		if (drop) {
+			si->dir_index_lookups = 0;
+			scoutfs_inc_counter(sb, dir_index_drop);
+		}
+		return dind;
+	}
+
+	return NULL;
+}
+
+/*
+ * Build an index from all the dirent items in the directory and
+ * install it if another index wasn't installed while we were building.
+ */
+static int build_dir_index(struct super_block *sb, struct inode *dir,
+			   struct scoutfs_lock *lock)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(dir);
+	struct scoutfs_dir_index *dind = NULL;
+	struct scoutfs_dirent *dent = NULL;
+	struct dir_index_entry *ent;
+	struct scoutfs_key last_key;
+	struct scoutfs_key key;
+	struct hlist_node *tmp;
+	HLIST_HEAD(list);
+	unsigned long nr = 0;
+	unsigned long i;
+	u64 dir_ino = scoutfs_ino(dir);
+	int ret;
+
+	dent = alloc_dirent(SCOUTFS_NAME_LEN);
+	if (!dent) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	init_dirent_key(&key, SCOUTFS_DIRENT_TYPE, dir_ino, 0, 0);
+	init_dirent_key(&last_key, SCOUTFS_DIRENT_TYPE, dir_ino, U64_MAX, U64_MAX);
+
+	for (;;) {
+		ret = scoutfs_item_next(sb, &key, &last_key, dent,
+					dirent_bytes(SCOUTFS_NAME_LEN), lock);
+		if (ret < 0) {
+			if (ret == -ENOENT)
+				ret = 0;
+			break;
+		}
+
+		ret -= sizeof(struct scoutfs_dirent);
+		if (ret < 1 || ret > SCOUTFS_NAME_LEN) {
+			scoutfs_corruption(sb, SC_DIRENT_NAME_LEN,
+					   corrupt_dirent_name_len,
+					   "dir_ino %llu key "SK_FMT" len %d",
+					   dir_ino, SK_ARG(&key), ret);
+			ret = -EIO;
+			goto out;
+		}
+
+		ent = alloc_dir_index_entry(dent, dent->name, ret);
+		if (!ent) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		hlist_add_head(&ent->head, &list);
+		nr++;
+
+		if (key.skd_major == cpu_to_le64(U64_MAX) &&
+		    key.skd_minor == cpu_to_le64(U64_MAX))
+			break;
+		scoutfs_key_inc(&key);
+		cond_resched();
+	}
+
+	dind = kmalloc(sizeof(struct scoutfs_dir_index), GFP_NOFS);
+	if (!dind) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	dind->refresh_gen = lock->refresh_gen;
+	dind->nr = nr;
+	dind->nr_buckets = roundup_pow_of_two(max_t(unsigned long, nr,
+							     DIR_INDEX_MIN_BUCKETS));
+	dind->buckets = __vmalloc(dind->nr_buckets * sizeof(struct hlist_head),
+				  GFP_NOFS, PAGE_KERNEL);
+	if (!dind->buckets) {
+		kfree(dind);
+		dind = NULL;
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < dind->nr_buckets; i++)
+		INIT_HLIST_HEAD(&dind->buckets[i]);
+
+	hlist_for_each_entry_safe(ent, tmp, &list, head) {
+		hlist_del(&ent->head);
+		hlist_add_head(&ent->head,
+			       dir_index_bucket(dind, le64_to_cpu(ent->dent.hash)));
+	}
+
+	spin_lock(&si->dir_index_lock);
+	if (!si->dir_index) {
+		swap(si->dir_index, dind);
+		scoutfs_inc_counter(sb, dir_index_build);
+	}
+	spin_unlock(&si->dir_index_lock);
+
+	ret = 0;
+out:
+	hlist_for_each_entry_safe(ent, tmp, &list, head)
+		kfree(ent);
+	free_dir_index(dind);
+	kfree(dent);
+
+	return ret;
+}
+
+/*
+ * Look up a name's dirent in a dir whose inode lock is held.  The dir's
+ * index is used if it's current, otherwise we count lookups under the
+ * lock and build the index once there have been enough.  Returns 0 or
+ * -ENOENT as lookup_dirent does.
+ */
+static int lookup_dir_dirent(struct super_block *sb, struct inode *dir,
+			     const char *name, unsigned name_len, u64 hash,
+			     struct scoutfs_dirent *dent_ret,
+			     struct scoutfs_lock *lock)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(dir);
+	struct scoutfs_dir_index *stale = NULL;
+	struct scoutfs_mount_options opts;
+	struct dir_index_entry *ent;
+	bool indexed = false;
+	bool build = false;
+	int ret = -ENOENT;
+
+	scoutfs_options_read(sb, &opts);
+
+	spin_lock(&si->dir_index_lock);
+	stale = detach_dir_index(sb, si, lock, opts.dir_index_lookups == 0);
+	if (si->dir_index) {
+		hlist_for_each_entry(ent, dir_index_bucket(si->dir_index, hash), head) {
+			if (le64_to_cpu(ent->dent.hash) == hash &&
+			    dirent_names_equal(name, name_len, ent->dent.name,
+					       ent->name_len)) {
+				*dent_ret = ent->dent;
+				ret = 0;
+				break;
+			}
+		}
+		indexed = true;
+
+	} else if (opts.dir_index_lookups > 0) {
+		if (si->dir_index_lookup_gen != lock->refresh_gen) {
+			si->dir_index_lookup_gen = lock->refresh_gen;
+			si->dir_index_lookups = 0;
+		}
+		build = ++si->dir_index_lookups == opts.dir_index_lookups;
+	}
+	spin_unlock(&si->dir_index_lock);
+
+	free_dir_index(stale);
+
+	if (indexed) {
+		scoutfs_inc_counter(sb, dir_index_hit);
+		return ret;
+	}
+
+	/* fall back to searching items if building fails */
+	if (build)
+		build_dir_index(sb, dir, lock);
+
+	return lookup_dirent(sb, scoutfs_ino(dir), name, name_len, hash,
+			     dent_ret, lock);
+}
+
+/*
+ * Keep the dir's current index up to date with an added entry.  The
+ * index is dropped if we can't allocate the entry or if it's grown
+ * well past its buckets.
+ */
+static void dir_index_add(struct super_block *sb, struct inode *dir,
+			  struct scoutfs_lock *lock, struct scoutfs_dirent *dent,
+			  const char *name, unsigned int name_len)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(dir);
+	struct scoutfs_dir_index *stale;
+	struct dir_index_entry *ent;
+	struct scoutfs_dir_index *dind;
+
+	if (!READ_ONCE(si->dir_index))
+		return;
+
+	ent = alloc_dir_index_entry(dent, name, name_len);
+
+	spin_lock(&si->dir_index_lock);
+	dind = si->dir_index;
+	stale = detach_dir_index(sb, si, lock,
+				 !ent || (dind && dind->nr >= dind->nr_buckets * 2));
+	dind = si->dir_index;
+	if (dind) {
+		hlist_add_head(&ent->head, dir_index_bucket(dind, le64_to_cpu(dent->hash)));
+		dind->nr++;
+		ent = NULL;
+	}
+	spin_unlock(&si->dir_index_lock);
+
+	kfree(ent);
+	free_dir_index(stale);
+}
+
+static void dir_index_del(struct super_block *sb, struct inode *dir,
+			  struct scoutfs_lock *lock, u64 hash, u64 pos)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(dir);
+	struct dir_index_entry *found = NULL;
+	struct scoutfs_dir_index *stale;
+	struct dir_index_entry *ent;
+	struct scoutfs_dir_index *dind;
+
+	if (!READ_ONCE(si->dir_index))
+		return;
+
+	spin_lock(&si->dir_index_lock);
+	stale = detach_dir_index(sb, si, lock, false);
+	dind = si->dir_index;
+	if (dind) {
+		hlist_for_each_entry(ent, dir_index_bucket(dind, hash), head) {
+			if (le64_to_cpu(ent->dent.hash) == hash &&
+			    le64_to_cpu(ent->dent.pos) == pos) {
+				hlist_del(&ent->head);
+				dind->nr--;
+				found = ent;
+				break;
+			}
+		}
+	}
+	spin_unlock(&si->dir_index_lock);
+
+	kfree(found);
+	free_dir_index(stale);
+}
+
+/*
+ * Free the dir's index when its cluster lock is invalidated.  The
+ * caller doesn't hold the dir's inode lock so we can race with lookups
+ * and modifications and only detach the index under its spinlock.
+ */
+void scoutfs_dir_invalidate_index(struct inode *inode)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+	struct scoutfs_dir_index *stale;
+
+	if (!READ_ONCE(si->dir_index))
+		return;
+
+	spin_lock(&si->dir_index_lock);
+	stale = detach_dir_index(inode->i_sb, si, NULL, true);
+	spin_unlock(&si->dir_index_lock);
+
+	free_dir_index(stale);
+}
+
+void scoutfs_dir_destroy_index(struct inode *inode)
+{
+	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
+
+	free_dir_index(si->dir_index);
+	si->dir_index = NULL;
+	/* the next instance of this slab object starts counting again */
+	si->dir_index_lookup_gen = 0;
+	si->dir_index_lookups = 0;
+}
+
 static u64 dentry_parent_ino(struct dentry *dentry)
 {
 	struct dentry *parent = NULL;
@@ -323,6 +688,51 @@ out:
 	return ret;
 }
 
+/*
+ * A dentry's fsdata no longer matches its dir's lock once the lock has
+ * been invalidated and granted again, typically because another mount
+ * modified the dir.  Rather than dropping the dentry, and all the
+ * cached dentries beneath it, we check if the dirent item for its name
+ * still refers to the same inode, or is still missing for negative
+ * dentries.  If it does then the dentry is still valid for the new
+ * lock and we can store its refresh_gen.  Items that weren't modified
+ * are often retained across lock invalidation so this lookup can be
+ * satisfied by the item cache.
+ *
+ * Returns 1 if the dentry is still valid, 0 if it isn't, or -errno.
+ */
+static int revalidate_dentry_dirent(struct super_block *sb, u64 dir_ino,
+				    struct dentry *dentry)
+{
+	struct scoutfs_dirent dent = {0,};
+	struct scoutfs_lock *lock = NULL;
+	int ret;
+
+	if (dir_ino == 0 || dentry->d_name.len > SCOUTFS_NAME_LEN)
+		return 0;
+
+	scoutfs_inc_counter(sb, dentry_revalidate_dirent);
+
+	ret = scoutfs_lock_ino(sb, SCOUTFS_LOCK_READ, 0, dir_ino, &lock);
+	if (ret < 0)
+		return ret;
+
+	ret = lookup_dentry_dirent(sb, dir_ino, dentry, &dent, lock);
+	if (ret == 0 || ret == -ENOENT) {
+		/* dent.ino is still 0 if the dirent wasn't found */
+		if (le64_to_cpu(dent.ino) == dentry_ino(dentry)) {
+			set_dentry_fsdata(dentry, lock);
+			ret = 1;
+		} else {
+			ret = 0;
+		}
+	}
+
+	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+
+	return ret;
+}
+
 static int scoutfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 {
 	struct super_block *sb = dentry->d_sb;
@@ -348,13 +758,15 @@ static int scoutfs_d_revalidate(struct dentry *dentry, unsigned int flags)
 		goto out;
 	}
 
-	if (test_dentry_fsdata(dentry, scoutfs_lock_ino_refresh_gen(sb, dir_ino))) {
-		scoutfs_inc_counter(sb, dentry_revalidate_valid);
+	if (test_dentry_fsdata(dentry, scoutfs_lock_ino_refresh_gen(sb, dir_ino)))
 		ret = 1;
-	} else {
+	else
+		ret = revalidate_dentry_dirent(sb, dir_ino, dentry);
+
+	if (ret == 1)
+		scoutfs_inc_counter(sb, dentry_revalidate_valid);
+	else if (ret == 0)
 		scoutfs_inc_counter(sb, dentry_revalidate_invalid);
-		ret = 0;
-	}
 
 out:
 	trace_scoutfs_d_revalidate(sb, dentry, flags, dir_ino, ret);
@@ -398,8 +810,8 @@ static struct dentry *scoutfs_lookup(struct inode *dir, struct dentry *dentry,
 	if (ret)
 		goto out;
 
-	ret = lookup_dirent(sb, scoutfs_ino(dir), dentry->d_name.name,
-			    dentry->d_name.len, hash, &dent, dir_lock);
+	ret = lookup_dir_dirent(sb, dir, dentry->d_name.name,
+				dentry->d_name.len, hash, &dent, dir_lock);
 	if (ret == -ENOENT) {
 		ino = 0;
 		ret = 0;
@@ -520,7 +932,7 @@ out:
  *
  * If this returns an error then nothing will have changed.
  */
-static int add_entry_items(struct super_block *sb, u64 dir_ino, u64 hash,
+static int add_entry_items(struct super_block *sb, struct inode *dir, u64 hash,
 			   u64 pos, const char *name, unsigned name_len,
 			   u64 ino, umode_t mode, struct scoutfs_lock *dir_lock,
 			   struct scoutfs_lock *inode_lock)
@@ -529,6 +941,7 @@ static int add_entry_items(struct super_block *sb, u64 dir_ino, u64 hash,
 	struct scoutfs_key rdir_key;
 	struct scoutfs_key ent_key;
 	struct scoutfs_key lb_key;
+	u64 dir_ino = scoutfs_ino(dir);
 	bool del_rdir = false;
 	bool del_ent = false;
 	int ret;
@@ -569,6 +982,8 @@ out:
 			scoutfs_item_delete(sb, &ent_key, dir_lock);
 		if (del_rdir)
 			scoutfs_item_delete(sb, &rdir_key, dir_lock);
+	} else {
+		dir_index_add(sb, dir, dir_lock, dent, name, name_len);
 	}
 
 	kfree(dent);
@@ -583,13 +998,14 @@ out:
  *
  * If this returns an error then nothing will have changed.
  */
-static int del_entry_items(struct super_block *sb, u64 dir_ino, u64 hash,
+static int del_entry_items(struct super_block *sb, struct inode *dir, u64 hash,
 			   u64 pos, u64 ino, struct scoutfs_lock *dir_lock,
 			   struct scoutfs_lock *inode_lock)
 {
 	struct scoutfs_key rdir_key;
 	struct scoutfs_key ent_key;
 	struct scoutfs_key lb_key;
+	u64 dir_ino = scoutfs_ino(dir);
 	int ret;
 
 	init_dirent_key(&ent_key, SCOUTFS_DIRENT_TYPE, dir_ino, hash, pos);
@@ -604,6 +1020,7 @@ static int del_entry_items(struct super_block *sb, u64 dir_ino, u64 hash,
 		      scoutfs_item_delete(sb, &rdir_key, dir_lock) ?:
 		      scoutfs_item_delete(sb, &lb_key, inode_lock);
 		BUG_ON(ret); /* _dirty should have guaranteed success */
+		dir_index_del(sb, dir, dir_lock, hash, pos);
 	}
 
 	return ret;
@@ -725,7 +1142,7 @@ static int scoutfs_mknod(struct inode *dir, struct dentry *dentry, umode_t mode,
 
 	pos = SCOUTFS_I(dir)->next_readdir_pos++;
 
-	ret = add_entry_items(sb, scoutfs_ino(dir), hash, pos,
+	ret = add_entry_items(sb, dir, hash, pos,
 			      dentry->d_name.name, dentry->d_name.len,
 			      scoutfs_ino(inode), inode->i_mode, dir_lock,
 			      inode_lock);
@@ -847,7 +1264,7 @@ retry:
 
 	pos = SCOUTFS_I(dir)->next_readdir_pos++;
 
-	ret = add_entry_items(sb, scoutfs_ino(dir), hash, pos,
+	ret = add_entry_items(sb, dir, hash, pos,
 			      dentry->d_name.name, dentry->d_name.len,
 			      scoutfs_ino(inode), inode->i_mode, dir_lock,
 			      inode_lock);
@@ -928,8 +1345,8 @@ static int scoutfs_unlink(struct inode *dir, struct dentry *dentry)
 
 	hash = dirent_name_hash(dentry->d_name.name, dentry->d_name.len);
 
-	ret = lookup_dirent(sb, scoutfs_ino(dir), dentry->d_name.name, dentry->d_name.len, hash,
-			    &dent, dir_lock);
+	ret = lookup_dir_dirent(sb, dir, dentry->d_name.name, dentry->d_name.len, hash,
+				&dent, dir_lock);
 	if (ret < 0)
 		goto out;
 
@@ -956,7 +1373,7 @@ retry:
 			goto out;
 	}
 
-	ret = del_entry_items(sb, scoutfs_ino(dir), le64_to_cpu(dent.hash), le64_to_cpu(dent.pos),
+	ret = del_entry_items(sb, dir, le64_to_cpu(dent.hash), le64_to_cpu(dent.pos),
 			      scoutfs_ino(inode), dir_lock, inode_lock);
 	if (ret) {
 		ret = scoutfs_inode_orphan_delete(sb, scoutfs_ino(inode), orph_lock, inode_lock);
@@ -1203,7 +1620,7 @@ static int scoutfs_symlink(struct inode *dir, struct dentry *dentry,
 
 	pos = SCOUTFS_I(dir)->next_readdir_pos++;
 
-	ret = add_entry_items(sb, scoutfs_ino(dir), hash, pos,
+	ret = add_entry_items(sb, dir, hash, pos,
 			      dentry->d_name.name, dentry->d_name.len,
 			      scoutfs_ino(inode), inode->i_mode, dir_lock,
 			      inode_lock);
@@ -1351,6 +1768,86 @@ out:
 	return nr ?: ret;
 }
 
+/*
+ * Add entries for the next count readdir items in the directory, from
+ * the given position, to the tail of the caller's list in position
+ * order.  The directory's lock is only held while the items are read
+ * so that callers are free to go on to lock the entries' inodes.
+ *
+ * Returns +ve for number of entries added, 0 if there were no more
+ * entries in the directory, or -errno on error.  Entries that were
+ * added before an error remain on the list for the caller to free.
+ */
+int scoutfs_dir_add_next_readdir_ents(struct super_block *sb, struct inode *dir, u64 pos,
+				      int count, struct list_head *list)
+{
+	struct scoutfs_readdir_entry *ent;
+	struct scoutfs_dirent *dent = NULL;
+	struct scoutfs_lock *lock = NULL;
+	struct scoutfs_key last_key;
+	struct scoutfs_key key;
+	int name_len;
+	int nr = 0;
+	int ret;
+
+	dent = alloc_dirent(SCOUTFS_NAME_LEN);
+	if (!dent) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	init_dirent_key(&key, SCOUTFS_READDIR_TYPE, scoutfs_ino(dir), pos, 0);
+	init_dirent_key(&last_key, SCOUTFS_READDIR_TYPE, scoutfs_ino(dir),
+			SCOUTFS_DIRENT_LAST_POS, 0);
+
+	ret = scoutfs_lock_inode(sb, SCOUTFS_LOCK_READ, 0, dir, &lock);
+	if (ret)
+		goto out;
+
+	while (nr < count) {
+		ret = scoutfs_item_next(sb, &key, &last_key, dent,
+					dirent_bytes(SCOUTFS_NAME_LEN), lock);
+		if (ret < 0) {
+			if (ret == -ENOENT)
+				ret = 0;
+			goto out;
+		}
+
+		name_len = ret - sizeof(struct scoutfs_dirent);
+		if (name_len < 1 || name_len > SCOUTFS_NAME_LEN) {
+			scoutfs_corruption(sb, SC_DIRENT_READDIR_NAME_LEN,
+					   corrupt_dirent_readdir_name_len,
+					   "dir_ino %llu pos %llu key "SK_FMT" len %d",
+					   scoutfs_ino(dir), pos, SK_ARG(&key), name_len);
+			ret = -EIO;
+			goto out;
+		}
+
+		ent = kmalloc(offsetof(struct scoutfs_readdir_entry, name[name_len]), GFP_NOFS);
+		if (!ent) {
+			ret = -ENOMEM;
+			goto out;
+		}
+
+		ent->pos = le64_to_cpu(key.skd_major);
+		ent->ino = le64_to_cpu(dent->ino);
+		ent->d_type = dentry_type(dent->type);
+		ent->name_len = name_len;
+		memcpy(ent->name, dent->name, name_len);
+
+		list_add_tail(&ent->head, list);
+		nr++;
+		scoutfs_key_inc(&key);
+	}
+
+	ret = 0;
+out:
+	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+
+	kfree(dent);
+	return nr ?: ret;
+}
+
 static u64 first_backref_dir_ino(struct list_head *list)
 {
 	struct scoutfs_link_backref_entry *ent;
@@ -1668,11 +2165,11 @@ retry:
 
 	/* remove the new entry if it exists */
 	if (new_inode) {
-		ret = lookup_dirent(sb, scoutfs_ino(new_dir), new_dentry->d_name.name,
-				    new_dentry->d_name.len, new_hash, &new_dent, new_dir_lock);
+		ret = lookup_dir_dirent(sb, new_dir, new_dentry->d_name.name,
+					new_dentry->d_name.len, new_hash, &new_dent, new_dir_lock);
 		if (ret < 0)
 			goto out;
-		ret = del_entry_items(sb, scoutfs_ino(new_dir), le64_to_cpu(new_dent.hash),
+		ret = del_entry_items(sb, new_dir, le64_to_cpu(new_dent.hash),
 				      le64_to_cpu(new_dent.pos), scoutfs_ino(new_inode),
 				      new_dir_lock, new_inode_lock);
 		if (ret)
@@ -1681,7 +2178,7 @@ retry:
 	}
 
 	/* create the new entry */
-	ret = add_entry_items(sb, scoutfs_ino(new_dir), new_hash, new_pos,
+	ret = add_entry_items(sb, new_dir, new_hash, new_pos,
 			      new_dentry->d_name.name, new_dentry->d_name.len,
 			      scoutfs_ino(old_inode), old_inode->i_mode,
 			      new_dir_lock, old_inode_lock);
@@ -1689,13 +2186,13 @@ retry:
 		goto out;
 	del_new = true;
 
-	ret = lookup_dirent(sb, scoutfs_ino(old_dir), old_dentry->d_name.name,
-			    old_dentry->d_name.len, old_hash, &old_dent, old_dir_lock);
+	ret = lookup_dir_dirent(sb, old_dir, old_dentry->d_name.name,
+				old_dentry->d_name.len, old_hash, &old_dent, old_dir_lock);
 	if (ret < 0)
 		goto out;
 
 	/* remove the old entry */
-	ret = del_entry_items(sb, scoutfs_ino(old_dir), le64_to_cpu(old_dent.hash),
+	ret = del_entry_items(sb, old_dir, le64_to_cpu(old_dent.hash),
 			      le64_to_cpu(old_dent.pos), scoutfs_ino(old_inode),
 			      old_dir_lock, old_inode_lock);
 	if (ret)
@@ -1776,7 +2273,7 @@ out:
 		 */
 		err = 0;
 		if (ins_old)
-			err = add_entry_items(sb, scoutfs_ino(old_dir),
+			err = add_entry_items(sb, old_dir,
 					      le64_to_cpu(old_dent.hash),
 					      le64_to_cpu(old_dent.pos),
 					      old_dentry->d_name.name,
@@ -1787,13 +2284,13 @@ out:
 					      old_inode_lock);
 
 		if (del_new && err == 0)
-			err = del_entry_items(sb, scoutfs_ino(new_dir),
+			err = del_entry_items(sb, new_dir,
 					      new_hash, new_pos,
 					      scoutfs_ino(old_inode),
 					      new_dir_lock, old_inode_lock);
 
 		if (ins_new && err == 0)
-			err = add_entry_items(sb, scoutfs_ino(new_dir),
+			err = add_entry_items(sb, new_dir,
 					      le64_to_cpu(new_dent.hash),
 					      le64_to_cpu(new_dent.pos),
 					      new_dentry->d_name.name,
@@ -25,6 +25,9 @@ struct scoutfs_link_backref_entry {
 	/* the full name is allocated and stored in dent.name[] */
 };
 
+void scoutfs_dir_invalidate_index(struct inode *inode);
+void scoutfs_dir_destroy_index(struct inode *inode);
+
 int scoutfs_dir_get_backref_path(struct super_block *sb, u64 ino, u64 dir_ino,
 				 u64 dir_pos, struct list_head *list);
 void scoutfs_dir_free_backref_path(struct super_block *sb,
@@ -33,6 +36,18 @@ void scoutfs_dir_free_backref_path(struct super_block *sb,
 int scoutfs_dir_add_next_linkrefs(struct super_block *sb, u64 ino, u64 dir_ino, u64 dir_pos,
 				  int count, struct list_head *list);
 
+struct scoutfs_readdir_entry {
+	struct list_head head;
+	u64 pos;
+	u64 ino;
+	u8 d_type;
+	u8 name_len;
+	char name[];
+};
+
+int scoutfs_dir_add_next_readdir_ents(struct super_block *sb, struct inode *dir, u64 pos,
+				      int count, struct list_head *list);
+
 int scoutfs_symlink_drop(struct super_block *sb, u64 ino,
 			 struct scoutfs_lock *lock, u64 i_size);
 
@@ -96,6 +96,8 @@ ssize_t scoutfs_file_aio_write(struct kiocb *iocb, const struct iovec *iov,
 	struct scoutfs_lock *scoutfs_inode_lock = NULL;
 	SCOUTFS_DECLARE_PER_TASK_ENTRY(pt_ent);
 	DECLARE_DATA_WAIT(dw);
+	loff_t write_pos;
+	size_t count;
 	int ret;
 
 	if (iocb->ki_left == 0) /* Does this even happen? */
@@ -124,7 +126,17 @@ retry:
 
 	/* XXX: remove SUID bit */
 
+	/* O_APPEND and limits are only applied by the write checks */
+	write_pos = pos;
+	count = iov_length(iov, nr_segs);
+	ret = generic_write_checks(file, &write_pos, &count,
+				   S_ISBLK(inode->i_mode));
+	if (ret)
+		goto out;
+
+	si->write_end = DIV_ROUND_UP(write_pos + count, SCOUTFS_BLOCK_SM_SIZE);
 	ret = __generic_file_aio_write(iocb, iov, nr_segs, &iocb->ki_pos);
+	si->write_end = 0;
 
 out:
 	scoutfs_per_task_del(&si->pt_data_lock, &pt_ent);
@@ -235,7 +247,10 @@ retry:
 
 	/* XXX: remove SUID bit */
 
+	si->write_end = DIV_ROUND_UP(iocb->ki_pos + iov_iter_count(from),
+				     SCOUTFS_BLOCK_SM_SIZE);
 	written = __generic_file_write_iter(iocb, from);
+	si->write_end = 0;
 
 out:
 	scoutfs_per_task_del(&si->pt_data_lock, &pt_ent);
@@ -949,7 +949,9 @@ struct scoutfs_net_greeting {
 
 #define SCOUTFS_NET_GREETING_FLAG_FAREWELL	(1 << 0)
 #define SCOUTFS_NET_GREETING_FLAG_QUORUM	(1 << 1)
-#define SCOUTFS_NET_GREETING_FLAG_INVALID	(~(__u64)0 << 2)
+/* set in the server's response if it processes batched lock requests */
+#define SCOUTFS_NET_GREETING_FLAG_LOCK_BATCH	(1 << 2)
+#define SCOUTFS_NET_GREETING_FLAG_INVALID	(~(__u64)0 << 3)
 
 /*
  * This header precedes and describes all network messages sent over
@@ -1007,6 +1009,7 @@ enum scoutfs_net_cmd {
 	SCOUTFS_NET_CMD_RESIZE_DEVICES,
 	SCOUTFS_NET_CMD_STATFS,
 	SCOUTFS_NET_CMD_FAREWELL,
+	SCOUTFS_NET_CMD_LOCK_BATCH,
 	SCOUTFS_NET_CMD_UNKNOWN,
 };
 
@@ -1067,9 +1070,20 @@ struct scoutfs_net_lock {
 	__le64 write_seq;
 	__u8 old_mode;
 	__u8 new_mode;
-	__u8 __pad[6];
+	__u8 flags;
+	__u8 __pad[5];
 };
 
+/*
+ * Read grants and invalidations of read locks to null set MOD_SEQ to
+ * indicate that write_seq holds the server's seq of the last possible
+ * modification of the lock's items.  Clients set UNMODIFIED in
+ * invalidation responses when they didn't write items under a write
+ * lock.
+ */
+#define SCOUTFS_NET_LOCK_FLAG_MOD_SEQ		(1 << 0)
+#define SCOUTFS_NET_LOCK_FLAG_UNMODIFIED	(1 << 1)
+
 struct scoutfs_net_lock_recover {
 	__le16 nr;
 	__u8 __pad[6];
@@ -1080,6 +1094,20 @@ struct scoutfs_net_lock_recover {
 	((SCOUTFS_NET_MAX_DATA_LEN - sizeof(struct scoutfs_net_lock_recover)) /\
 	 sizeof(struct scoutfs_net_lock))
 
+/*
+ * A batch of lock requests that the server only grants if they're
+ * compatible with all current grants.  The response contains all the
+ * requested locks and those that weren't granted have an invalid mode.
+ * Locks are sorted by their key.
+ */
+struct scoutfs_net_lock_batch {
+	__le16 nr;
+	__u8 __pad[6];
+	struct scoutfs_net_lock locks[];
+};
+
+#define SCOUTFS_NET_LOCK_BATCH_MAX_NR	8
+
 /* some enums for tracing */
 enum scoutfs_lock_trace {
 	SLT_CLIENT,
@@ -73,6 +73,10 @@ struct inode_sb_info {
 	struct work_struct iput_work;
 	spinlock_t iput_lock;
 	struct list_head iput_list;
+
+	struct work_struct delete_work;
+	spinlock_t delete_lock;
+	struct list_head delete_list;
 };
 
 #define DECLARE_INODE_SB_INFO(sb, name) \
@@ -90,9 +94,16 @@ static void scoutfs_inode_ctor(void *obj)
 	struct scoutfs_inode_info *si = obj;
 
 	init_rwsem(&si->extent_sem);
+	spin_lock_init(&si->ext_cache_lock);
+	si->ext_cache_gen = 0;
+	spin_lock_init(&si->dir_index_lock);
+	si->dir_index = NULL;
+	si->dir_index_lookup_gen = 0;
+	si->dir_index_lookups = 0;
 	mutex_init(&si->item_mutex);
 	seqcount_init(&si->seqcount);
 	si->staging = false;
+	si->write_end = 0;
 	scoutfs_per_task_init(&si->pt_data_lock);
 	atomic64_set(&si->data_waitq.changed, 0);
 	init_waitqueue_head(&si->data_waitq.waitq);
@@ -136,6 +147,9 @@ void scoutfs_destroy_inode(struct inode *inode)
 	spin_unlock(&inf->writeback_lock);
 
 	scoutfs_lock_del_coverage(inode->i_sb, &si->ino_lock_cov);
+	scoutfs_dir_destroy_index(inode);
+	/* the next instance of this slab object can share our locks */
+	si->ext_cache_gen = 0;
 
 	call_rcu(&inode->i_rcu, scoutfs_i_callback);
 }
@@ -498,6 +512,9 @@ retry:
 		if (ret)
 			goto out;
 
+		/* direct IO readers can be using extents we'd truncate */
+		inode_dio_wait(inode);
+
 		/* data_version is per inode, all must be online */
 		if (attr_size > 0 && attr_size != i_size_read(inode)) {
 			ret = scoutfs_data_wait_check(inode, 0, attr_size,
@@ -1544,48 +1561,64 @@ int scoutfs_inode_orphan_delete(struct super_block *sb, u64 ino, struct scoutfs_
 }
 
 /*
- * Remove all the items associated with a given inode.  This is only
- * called once nlink has dropped to zero and nothing has the inode open
- * so we don't have to worry about dirents referencing the inode or link
- * backrefs.  Dropping nlink to 0 also created an orphan item.  That
- * orphan item will continue triggering attempts to finish previous
+ * Remove all the items associated with given inodes.  This is only
+ * called once nlink has dropped to zero and nothing has the inodes open
+ * so we don't have to worry about dirents referencing the inodes or
+ * link backrefs.  Dropping nlink to 0 also created an orphan item.
+ * That orphan item will continue triggering attempts to finish previous
  * partial deletion until all deletion is complete and the orphan item
  * is removed.
+ *
+ * The unbounded number of data and xattr items are removed for each
+ * inode in their own transactions.  The small known number of remaining
+ * items for many inodes are then removed together in each transaction.
  */
-static int delete_inode_items(struct super_block *sb, u64 ino, struct scoutfs_inode *sinode,
-			      struct scoutfs_lock *lock, struct scoutfs_lock *orph_lock)
+#define DELETE_INODES_PER_TRANS 16
+
+struct delete_inode_cand {
+	u64 ino;
+	int bit_nr;
+	struct scoutfs_inode sinode;
+};
+
+static int delete_inode_data(struct super_block *sb, u64 ino, struct scoutfs_inode *sinode,
+			     struct scoutfs_lock *lock)
+{
+	umode_t mode = le32_to_cpu(sinode->mode);
+	int ret = 0;
+
+	trace_scoutfs_delete_inode(sb, ino, mode, le64_to_cpu(sinode->size));
+
+	/* remove data items in their own transactions */
+	if (S_ISREG(mode))
+		ret = scoutfs_data_truncate_items(sb, NULL, ino, 0, ~0ULL, false, lock);
+
+	return ret ?: scoutfs_xattr_drop(sb, ino, lock);
+}
+
+static int delete_inode_items(struct super_block *sb, struct delete_inode_cand *cands,
+			      int nr, struct scoutfs_lock *lock, struct scoutfs_lock *orph_lock)
 {
+	struct scoutfs_inode *sinode;
 	struct scoutfs_key key;
 	LIST_HEAD(ind_locks);
 	bool release = false;
 	umode_t mode;
 	u64 ind_seq;
-	u64 size;
+	u64 ino;
 	int ret;
-
-	scoutfs_inode_init_key(&key, ino);
-
-	mode = le32_to_cpu(sinode->mode);
-	size = le64_to_cpu(sinode->size);
-	trace_scoutfs_delete_inode(sb, ino, mode, size);
-
-	/* remove data items in their own transactions */
-	if (S_ISREG(mode)) {
-		ret = scoutfs_data_truncate_items(sb, NULL, ino, 0, ~0ULL,
-						  false, lock);
-		if (ret)
-			goto out;
-	}
-
-	ret = scoutfs_xattr_drop(sb, ino, lock);
-	if (ret)
-		goto out;
+	int i;
 
 	/* then delete the small known number of remaining inode items */
 retry:
-	ret = scoutfs_inode_index_start(sb, &ind_seq) ?:
-	      prepare_index_deletion(sb, &ind_locks, ino, mode, sinode) ?:
-	      scoutfs_inode_index_try_lock_hold(sb, &ind_locks, ind_seq, false);
+	ret = scoutfs_inode_index_start(sb, &ind_seq);
+	for (i = 0; ret == 0 && i < nr; i++) {
+		sinode = &cands[i].sinode;
+		ret = prepare_index_deletion(sb, &ind_locks, cands[i].ino,
+					     le32_to_cpu(sinode->mode), sinode);
+	}
+	if (ret == 0)
+		ret = scoutfs_inode_index_try_lock_hold(sb, &ind_locks, ind_seq, false);
 	if (ret > 0)
 		goto retry;
 	if (ret)
@@ -1593,29 +1626,37 @@ retry:
 
 	release = true;
 
-	ret = remove_index_items(sb, ino, sinode, &ind_locks, lock);
-	if (ret)
-		goto out;
+	for (i = 0; i < nr; i++) {
+		ino = cands[i].ino;
+		sinode = &cands[i].sinode;
+		mode = le32_to_cpu(sinode->mode);
+
+		scoutfs_inode_init_key(&key, ino);
 
-	if (S_ISLNK(mode)) {
-		ret = scoutfs_symlink_drop(sb, ino, lock, size);
+		ret = remove_index_items(sb, ino, sinode, &ind_locks, lock);
 		if (ret)
 			goto out;
-	}
 
-	/* make sure inode item and orphan are deleted together */
-	ret = scoutfs_item_dirty(sb, &key, lock);
-	if (ret < 0)
-		goto out;
+		if (S_ISLNK(mode)) {
+			ret = scoutfs_symlink_drop(sb, ino, lock, le64_to_cpu(sinode->size));
+			if (ret)
+				goto out;
+		}
 
-	ret = scoutfs_inode_orphan_delete(sb, ino, orph_lock, lock);
-	if (ret < 0)
-		goto out;
+		/* make sure inode item and orphan are deleted together */
+		ret = scoutfs_item_dirty(sb, &key, lock);
+		if (ret < 0)
+			goto out;
+
+		ret = scoutfs_inode_orphan_delete(sb, ino, orph_lock, lock);
+		if (ret < 0)
+			goto out;
 
-	ret = scoutfs_item_delete(sb, &key, lock);
-	BUG_ON(ret != 0); /* dirtying should have guaranteed success */
+		ret = scoutfs_item_delete(sb, &key, lock);
+		BUG_ON(ret != 0); /* dirtying should have guaranteed success */
 
-	scoutfs_forest_dec_inode_count(sb);
+		scoutfs_forest_dec_inode_count(sb);
+	}
 
 out:
 	if (release)
@@ -1694,7 +1735,7 @@ out:
 }
 
 /*
- * Try to delete all the items for an unused inode number.  This is the
+ * Try to delete all the items for unused inode numbers.  This is the
  * relatively slow path that uses cluster locks, network requests, and
  * IO to ensure correctness.  Callers should try hard to avoid calling
  * when there's no work to do.
@@ -1713,67 +1754,107 @@ out:
  * 0, and an omap request protected by the lock doesn't have the inode's
  * bit set.
  *
- * This is called by orphan scanning and vfs inode cache eviction after
- * they've checked that the inode could really be deleted.  We serialize
- * on a bit in the lock data so that we only have one deletion attempt
- * per inode under this mount's cluster lock.
+ * This is called by orphan scanning and background deletion after
+ * they've checked that the inodes could really be deleted.  All the
+ * inode numbers must be in the same inode lock group so that they're
+ * all checked and deleted under one lock and omap request.  We
+ * serialize on a bit in the lock data so that we only have one deletion
+ * attempt per inode under this mount's cluster lock.
  */
-static int try_delete_inode_items(struct super_block *sb, u64 ino)
+static int try_delete_inode_items(struct super_block *sb, const u64 *inos, int nr)
 {
 	struct inode_deletion_lock_data *ldata = NULL;
+	struct delete_inode_cand *cands = NULL;
+	struct delete_inode_cand *cand;
 	struct scoutfs_lock *orph_lock = NULL;
 	struct scoutfs_lock *lock = NULL;
-	struct scoutfs_inode sinode;
 	struct scoutfs_key key;
-	bool clear_trying = false;
 	u64 group_nr;
 	int bit_nr;
+	int cand_nr = 0;
 	int ret;
+	int i;
+
+	cands = kmalloc_array(nr, sizeof(cands[0]), GFP_NOFS);
+	if (!cands) {
+		ret = -ENOMEM;
+		goto out;
+	}
 
-	ret = scoutfs_lock_ino(sb, SCOUTFS_LOCK_WRITE, 0, ino, &lock);
+	ret = scoutfs_lock_ino(sb, SCOUTFS_LOCK_WRITE, 0, inos[0], &lock);
 	if (ret < 0)
 		goto out;
 
-	scoutfs_omap_calc_group_nrs(ino, &group_nr, &bit_nr);
+	scoutfs_omap_calc_group_nrs(inos[0], &group_nr, &bit_nr);
 
 	ret = get_current_lock_data(sb, lock, &ldata, group_nr);
 	if (ret < 0)
 		goto out;
 
-	/* only one local attempt per inode at a time */
-	if (test_and_set_bit(bit_nr, ldata->trying)) {
-		ret = 0;
-		goto out;
-	}
-	clear_trying = true;
+	for (i = 0; i < nr; i++) {
+		if (WARN_ON_ONCE((inos[i] & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK) !=
+				 (inos[0] & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK)))
+			continue;
 
-	/* can't delete if it's cached in local or remote mounts */
-	if (scoutfs_omap_test(sb, ino) || test_bit_le(bit_nr, ldata->map.bits)) {
-		ret = 0;
-		goto out;
-	}
+		scoutfs_omap_calc_group_nrs(inos[i], &group_nr, &bit_nr);
 
-	scoutfs_inode_init_key(&key, ino);
-	ret = scoutfs_item_lookup_exact(sb, &key, &sinode, sizeof(sinode), lock);
-	if (ret < 0) {
+		/* only one local attempt per inode at a time */
+		if (test_and_set_bit(bit_nr, ldata->trying))
+			continue;
+
+		cand = &cands[cand_nr];
+		cand->ino = inos[i];
+		cand->bit_nr = bit_nr;
+		cand_nr++;
+
+		/* can't delete if it's cached in local or remote mounts */
+		if (scoutfs_omap_test(sb, cand->ino) || test_bit_le(bit_nr, ldata->map.bits))
+			goto skip;
+
+		scoutfs_inode_init_key(&key, cand->ino);
+		ret = scoutfs_item_lookup_exact(sb, &key, &cand->sinode, sizeof(cand->sinode),
+						lock);
 		if (ret == -ENOENT)
-			ret = 0;
-		goto out;
+			goto skip;
+		if (ret < 0)
+			goto out;
+
+		if (le32_to_cpu(cand->sinode.nlink) > 0)
+			goto skip;
+
+		continue;
+skip:
+		clear_bit(bit_nr, ldata->trying);
+		cand_nr--;
 	}
 
-	if (le32_to_cpu(sinode.nlink) > 0) {
-		ret = 0;
+	ret = 0;
+	if (cand_nr == 0)
 		goto out;
-	}
 
-	ret = scoutfs_lock_orphan(sb, SCOUTFS_LOCK_WRITE_ONLY, 0, ino, &orph_lock);
+	ret = scoutfs_lock_orphan(sb, SCOUTFS_LOCK_WRITE_ONLY, 0, inos[0], &orph_lock);
 	if (ret < 0)
 		goto out;
 
-	ret = delete_inode_items(sb, ino, &sinode, lock, orph_lock);
+	for (i = 0; i < cand_nr; i++) {
+		ret = delete_inode_data(sb, cands[i].ino, &cands[i].sinode, lock);
+		if (ret < 0)
+			goto out;
+	}
+
+	for (i = 0; i < cand_nr; i += DELETE_INODES_PER_TRANS) {
+		ret = delete_inode_items(sb, &cands[i],
+					 min(cand_nr - i, DELETE_INODES_PER_TRANS),
+					 lock, orph_lock);
+		if (ret < 0)
+			goto out;
+	}
+
+	scoutfs_add_counter(sb, inode_deleted, cand_nr);
 out:
-	if (clear_trying)
-		clear_bit(bit_nr, ldata->trying);
+	for (i = 0; i < cand_nr; i++)
+		clear_bit(cands[i].bit_nr, ldata->trying);
+	kfree(cands);
 
 	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_WRITE);
 	scoutfs_unlock(sb, orph_lock, SCOUTFS_LOCK_WRITE_ONLY);
@@ -1781,13 +1862,109 @@ out:
 	return ret;
 }
 
+/*
+ * Inodes that are unlinked and evicted are deleted in the background
+ * so that the final unlinking task doesn't have to wait for all the
+ * items to be removed.  The orphan item that was created as nlink
+ * dropped to 0 keeps deletion crash safe: if we don't get to the
+ * deferred deletion then the orphan scan will.  The worker sorts the
+ * pending inode numbers so that inodes that share a lock group are
+ * deleted together.
+ */
+struct deferred_delete {
+	struct list_head head;
+	u64 ino;
+};
+
+#define DEFERRED_DELETE_BATCH 64
+
+static bool queue_deferred_delete(struct super_block *sb, u64 ino)
+{
+	DECLARE_INODE_SB_INFO(sb, inf);
+	struct deferred_delete *dd;
+
+	dd = kmalloc(sizeof(struct deferred_delete), GFP_NOFS);
+	if (!dd)
+		return false;
+
+	dd->ino = ino;
+
+	spin_lock(&inf->delete_lock);
+	list_add_tail(&dd->head, &inf->delete_list);
+	spin_unlock(&inf->delete_lock);
+
+	queue_work(inf->iput_workq, &inf->delete_work);
+	scoutfs_inc_counter(sb, inode_delete_deferred);
+
+	return true;
+}
+
+static int cmp_deferred_delete(void *priv, struct list_head *A, struct list_head *B)
+{
+	struct deferred_delete *a = list_entry(A, struct deferred_delete, head);
+	struct deferred_delete *b = list_entry(B, struct deferred_delete, head);
+
+	return scoutfs_cmp_u64s(a->ino, b->ino);
+}
+
+static void delete_worker(struct work_struct *work)
+{
+	struct inode_sb_info *inf = container_of(work, struct inode_sb_info, delete_work);
+	struct super_block *sb = inf->sb;
+	struct deferred_delete *dd;
+	struct deferred_delete *tmp;
+	u64 inos[DEFERRED_DELETE_BATCH];
+	LIST_HEAD(list);
+	int grp;
+	int nr;
+	int i;
+
+	for (;;) {
+		/* take a batch of pending inodes */
+		spin_lock(&inf->delete_lock);
+		nr = 0;
+		list_for_each_entry_safe(dd, tmp, &inf->delete_list, head) {
+			list_move_tail(&dd->head, &list);
+			if (++nr == DEFERRED_DELETE_BATCH)
+				break;
+		}
+		spin_unlock(&inf->delete_lock);
+
+		if (nr == 0)
+			break;
+
+		list_sort(NULL, &list, cmp_deferred_delete);
+
+		nr = 0;
+		list_for_each_entry_safe(dd, tmp, &list, head) {
+			inos[nr++] = dd->ino;
+			list_del_init(&dd->head);
+			kfree(dd);
+		}
+
+		/* delete each run of inodes in the same lock group together */
+		for (i = 0; i < nr; i += grp) {
+			for (grp = 1; i + grp < nr; grp++) {
+				if ((inos[i + grp] & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK) !=
+				    (inos[i] & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK))
+					break;
+			}
+
+			/* orphan scan will retry after errors */
+			if (try_delete_inode_items(sb, &inos[i], grp) < 0)
+				scoutfs_inc_counter(sb, inode_delete_deferred_error);
+		}
+	}
+}
+
 /*
  * As we evicted an inode we need to decide to try and delete its items
  * or not, which is expensive.  We only try when we have lock coverage
  * and the inode has been unlinked.  This catches the common case of
- * regular deletion so deletion will be performed in the final unlink
- * task.  It also catches open-unlink or o_tmpfile that aren't cached on
- * other nodes.
+ * regular deletion so deletion will be queued for background work as
+ * the final unlink task evicts.  It also catches open-unlink or
+ * o_tmpfile that aren't cached on other nodes.  We fall back to
+ * deleting in the evicting task if we can't queue.
  *
  * Inodes being evicted outside of lock coverage, by referenced dentries
  * or inodes that survived the attempt to drop them as their lock was
@@ -1809,8 +1986,9 @@ void scoutfs_evict_inode(struct inode *inode)
 		/* clear before trying to delete tests */
 		scoutfs_omap_clear(sb, ino);
 
-		if (scoutfs_lock_is_covered(sb, &si->ino_lock_cov) && inode->i_nlink == 0)
-			try_delete_inode_items(sb, scoutfs_ino(inode));
+		if (scoutfs_lock_is_covered(sb, &si->ino_lock_cov) && inode->i_nlink == 0 &&
+		    !queue_deferred_delete(sb, ino))
+			try_delete_inode_items(sb, &ino, 1);
 	}
 
 	clear_inode(inode);
@@ -2041,7 +2219,7 @@ static void inode_orphan_scan_worker(struct work_struct *work)
 
 		/* seemingly orphaned and unused, get locks and check for sure */
 		scoutfs_inc_counter(sb, orphan_scan_attempts);
-		ret = try_delete_inode_items(sb, ino);
+		ret = try_delete_inode_items(sb, &ino, 1);
 	}
 
 	ret = 0;
@@ -2161,6 +2339,9 @@ int scoutfs_inode_setup(struct super_block *sb)
 	INIT_WORK(&inf->iput_work, iput_worker);
 	spin_lock_init(&inf->iput_lock);
 	INIT_LIST_HEAD(&inf->iput_list);
+	INIT_WORK(&inf->delete_work, delete_worker);
+	spin_lock_init(&inf->delete_lock);
+	INIT_LIST_HEAD(&inf->delete_list);
 
 	/* re-entrant, worker locks with itself and queueing */
 	inf->iput_workq = alloc_workqueue("scoutfs_inode_iput", WQ_UNBOUND, 0);
@@ -2198,12 +2379,30 @@ void scoutfs_inode_orphan_stop(struct super_block *sb)
 	}
 }
 
-void scoutfs_inode_flush_iput(struct super_block *sb)
+/*
+ * Wait for pending background deletion so that callers see the space
+ * and inodes freed by deletion that was queued before they called.
+ */
+void scoutfs_inode_flush_deletes(struct super_block *sb)
 {
 	DECLARE_INODE_SB_INFO(sb, inf);
 
 	if (inf)
+		flush_work(&inf->delete_work);
+}
+
+/*
+ * Final iputs can queue deferred deletion so we wait for the iput work
+ * before waiting for the deletion work.
+ */
+void scoutfs_inode_flush_iput(struct super_block *sb)
+{
+	DECLARE_INODE_SB_INFO(sb, inf);
+
+	if (inf) {
 		flush_workqueue(inf->iput_workq);
+		flush_work(&inf->delete_work);
+	}
 }
 
 void scoutfs_inode_destroy(struct super_block *sb)
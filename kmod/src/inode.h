@@ -6,8 +6,10 @@
 #include "per_task.h"
 #include "format.h"
 #include "data.h"
+#include "ext.h"
 
 struct scoutfs_lock;
+struct scoutfs_dir_index;
 
 #define SCOUTFS_INODE_NR_INDICES 2
 
@@ -32,6 +34,27 @@ struct scoutfs_inode_info {
 	 */
 	struct rw_semaphore extent_sem;
 
+	/*
+	 * The most recently found extent is cached for the lock
+	 * refresh_gen it was read under.  Holders of extent_sem can
+	 * read and store it, protected by the spinlock.
+	 */
+	spinlock_t ext_cache_lock;
+	struct scoutfs_extent ext_cache;
+	u64 ext_cache_gen;
+
+	/*
+	 * Directories that see enough lookups under a lock build an
+	 * in-memory index of their dirent items.  The index is only
+	 * used under the lock refresh_gen it was built under and is
+	 * kept current as entries are added and removed, protected by
+	 * the spinlock.
+	 */
+	spinlock_t dir_index_lock;
+	struct scoutfs_dir_index *dir_index;
+	u64 dir_index_lookup_gen;
+	unsigned int dir_index_lookups;
+
 	/*
 	 * The in-memory item info caches the current index item values
 	 * so that we can decide to update them with comparisons instead
@@ -49,6 +72,7 @@ struct scoutfs_inode_info {
 	/* initialized once for slab object */
 	seqcount_t seqcount;
 	bool staging;			/* holder of i_mutex is staging */
+	u64 write_end;			/* holder of i_mutex's write end block */
 	struct scoutfs_per_task pt_data_lock;
 	struct scoutfs_data_waitq data_waitq;
 	struct rw_semaphore xattr_rwsem;
@@ -148,6 +172,7 @@ int scoutfs_inode_setup(struct super_block *sb);
 void scoutfs_inode_start(struct super_block *sb);
 void scoutfs_inode_orphan_stop(struct super_block *sb);
 void scoutfs_inode_flush_iput(struct super_block *sb);
+void scoutfs_inode_flush_deletes(struct super_block *sb);
 void scoutfs_inode_destroy(struct super_block *sb);
 
 #endif
@@ -23,6 +23,7 @@
 #include <linux/aio.h>
 #include <linux/list_sort.h>
 #include <linux/backing-dev.h>
+#include <linux/sort.h>
 
 #include "format.h"
 #include "key.h"
@@ -273,11 +274,10 @@ out:
  * XXX permissions?
  * XXX a lot of this could be generic file write prep
  */
-static long scoutfs_ioc_release(struct file *file, unsigned long arg)
+static long release_inode(struct inode *inode, u64 data_version,
+			  u64 offset, u64 length)
 {
-	struct inode *inode = file_inode(file);
 	struct super_block *sb = inode->i_sb;
-	struct scoutfs_ioctl_release args;
 	struct scoutfs_lock *lock = NULL;
 	u64 sblock;
 	u64 eblock;
@@ -286,23 +286,6 @@ static long scoutfs_ioc_release(struct file *file, unsigned long arg)
 	u64 isize;
 	int ret;
 
-	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
-		return -EFAULT;
-
-	trace_scoutfs_ioc_release(sb, scoutfs_ino(inode), &args);
-
-	if (args.length == 0)
-		return 0;
-	if (((args.offset + args.length) < args.offset) ||
-	    (args.offset & SCOUTFS_BLOCK_SM_MASK) ||
-	    (args.length & SCOUTFS_BLOCK_SM_MASK))
-		return -EINVAL;
-
-
-	ret = mnt_want_write_file(file);
-	if (ret)
-		return ret;
-
 	inode_lock(inode);
 
 	ret = scoutfs_lock_inode(sb, SCOUTFS_LOCK_WRITE,
@@ -315,12 +298,7 @@ static long scoutfs_ioc_release(struct file *file, unsigned long arg)
 		goto out;
 	}
 
-	if (!(file->f_mode & FMODE_WRITE)) {
-		ret = -EINVAL;
-		goto out;
-	}
-
-	if (scoutfs_inode_data_version(inode) != args.data_version) {
+	if (scoutfs_inode_data_version(inode) != data_version) {
 		ret = -ESTALE;
 		goto out;
 	}
@@ -328,11 +306,11 @@ static long scoutfs_ioc_release(struct file *file, unsigned long arg)
 	inode_dio_wait(inode);
 
 	/* drop all clean and dirty cached blocks in the range */
-	truncate_inode_pages_range(&inode->i_data, args.offset,
-				   args.offset + args.length - 1);
+	truncate_inode_pages_range(&inode->i_data, offset,
+				   offset + length - 1);
 
-	sblock = args.offset >> SCOUTFS_BLOCK_SM_SHIFT;
-	eblock = (args.offset + args.length - 1) >> SCOUTFS_BLOCK_SM_SHIFT;
+	sblock = offset >> SCOUTFS_BLOCK_SM_SHIFT;
+	eblock = (offset + length - 1) >> SCOUTFS_BLOCK_SM_SHIFT;
 	ret = scoutfs_data_truncate_items(sb, inode, scoutfs_ino(inode),
 					  sblock,
 					  eblock, true,
@@ -353,6 +331,44 @@ static long scoutfs_ioc_release(struct file *file, unsigned long arg)
 out:
 	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_WRITE);
 	inode_unlock(inode);
+
+	return ret;
+}
+
+static bool invalid_release_range(u64 offset, u64 length)
+{
+	return ((offset + length) < offset) ||
+	       (offset & SCOUTFS_BLOCK_SM_MASK) ||
+	       (length & SCOUTFS_BLOCK_SM_MASK);
+}
+
+static long scoutfs_ioc_release(struct file *file, unsigned long arg)
+{
+	struct inode *inode = file_inode(file);
+	struct super_block *sb = inode->i_sb;
+	struct scoutfs_ioctl_release args;
+	int ret;
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+
+	trace_scoutfs_ioc_release(sb, scoutfs_ino(inode), &args);
+
+	if (args.length == 0)
+		return 0;
+	if (invalid_release_range(args.offset, args.length))
+		return -EINVAL;
+
+	if (!(file->f_mode & FMODE_WRITE))
+		return -EINVAL;
+
+	ret = mnt_want_write_file(file);
+	if (ret)
+		return ret;
+
+	ret = release_inode(inode, args.data_version, args.offset,
+			    args.length);
+
 	mnt_drop_write_file(file);
 
 	trace_scoutfs_ioc_release_ret(sb, scoutfs_ino(inode), ret);
@@ -445,47 +461,29 @@ out:
  * This doesn't support any fancy write modes or side-effects: aio,
  * direct, append, sync, breaking suid, sending rlimit signals.
  */
-static long scoutfs_ioc_stage(struct file *file, unsigned long arg)
+static long stage_locked(struct file *file, u64 data_version, loff_t offset,
+			 loff_t length, struct iovec *iov, struct file *src,
+			 loff_t src_off)
 {
 	struct inode *inode = file_inode(file);
 	struct super_block *sb = inode->i_sb;
 	struct scoutfs_inode_info *si = SCOUTFS_I(inode);
 	SCOUTFS_DECLARE_PER_TASK_ENTRY(pt_ent);
-	struct scoutfs_ioctl_stage args;
 	struct scoutfs_lock *lock = NULL;
 	struct kiocb kiocb;
-	struct iovec iov;
+	loff_t end_size = offset + length;
 	size_t written;
-	loff_t end_size;
 	loff_t isize;
 	loff_t pos;
-	int ret;
-
-	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
-		return -EFAULT;
-
-	trace_scoutfs_ioc_stage(sb, scoutfs_ino(inode), &args);
-
-	end_size = args.offset + args.length;
-
-	/* verify arg constraints that aren't dependent on file */
-	if (args.length < 0 || (end_size < args.offset) ||
-	    args.offset & SCOUTFS_BLOCK_SM_MASK) {
-		return -EINVAL;
-	}
-
-	if (args.length == 0)
-		return 0;
+	long ret;
 
 	/* the iocb is really only used for the file pointer :P */
 	init_sync_kiocb(&kiocb, file);
-	kiocb.ki_pos = args.offset;
+	kiocb.ki_pos = offset;
 #ifdef KC_LINUX_AIO_KI_LEFT
-	kiocb.ki_left = args.length;
-	kiocb.ki_nbytes = args.length;
+	kiocb.ki_left = length;
+	kiocb.ki_nbytes = length;
 #endif
-	iov.iov_base = (void __user *)(unsigned long)args.buf_ptr;
-	iov.iov_len = args.length;
 
 	ret = mnt_want_write_file(file);
 	if (ret)
@@ -512,7 +510,7 @@ static long scoutfs_ioc_stage(struct file *file, unsigned long arg)
 		goto out;
 	}
 
-	if (scoutfs_inode_data_version(inode) != args.data_version) {
+	if (scoutfs_inode_data_version(inode) != data_version) {
 		ret = -ESTALE;
 		goto out;
 	}
@@ -520,15 +518,24 @@ static long scoutfs_ioc_stage(struct file *file, unsigned long arg)
 	si->staging = true;
 	current->backing_dev_info = inode_to_bdi(inode);
 
-	pos = args.offset;
-	written = 0;
-	do {
-		ret = generic_file_buffered_write(&kiocb, &iov, 1, pos, &pos,
-						  args.length, written);
-		BUG_ON(ret == -EIOCBQUEUED);
-		if (ret > 0)
-			written += ret;
-	} while (ret > 0 && written < args.length);
+	if (src) {
+		ret = scoutfs_data_stage_splice(file, offset, length, src,
+						src_off);
+		/* the source was checked, a short splice left a partial block */
+		if (ret >= 0 && ret != length)
+			ret = -EIO;
+	} else {
+		pos = offset;
+		written = 0;
+		do {
+			ret = generic_file_buffered_write(&kiocb, iov, 1, pos,
+							  &pos, length,
+							  written);
+			BUG_ON(ret == -EIOCBQUEUED);
+			if (ret > 0)
+				written += ret;
+		} while (ret > 0 && written < length);
+	}
 
 	si->staging = false;
 	current->backing_dev_info = NULL;
@@ -538,10 +545,318 @@ out:
 	inode_unlock(inode);
 	mnt_drop_write_file(file);
 
+	return ret;
+}
+
+static long scoutfs_ioc_stage(struct file *file, unsigned long arg)
+{
+	struct inode *inode = file_inode(file);
+	struct super_block *sb = inode->i_sb;
+	struct scoutfs_ioctl_stage args;
+	struct iovec iov;
+	loff_t end_size;
+	long ret;
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+
+	trace_scoutfs_ioc_stage(sb, scoutfs_ino(inode), &args);
+
+	end_size = args.offset + args.length;
+
+	/* verify arg constraints that aren't dependent on file */
+	if (args.length < 0 || (end_size < args.offset) ||
+	    args.offset & SCOUTFS_BLOCK_SM_MASK) {
+		return -EINVAL;
+	}
+
+	if (args.length == 0)
+		return 0;
+
+	iov.iov_base = (void __user *)(unsigned long)args.buf_ptr;
+	iov.iov_len = args.length;
+
+	ret = stage_locked(file, args.data_version, args.offset, args.length,
+			   &iov, NULL, 0);
+
 	trace_scoutfs_ioc_stage_ret(sb, scoutfs_ino(inode), ret);
 	return ret;
 }
 
+/*
+ * Stage from a source file instead of from a user buffer.  The source
+ * file's pages are spliced into a pipe and copied straight into our
+ * page cache pages so the data is only copied once.  The source can't
+ * be in a scoutfs file system, reading it would acquire cluster locks
+ * while we hold the destination's, and move_blocks can stage from
+ * files in the same file system without copying.
+ */
+static long scoutfs_ioc_stage_fd(struct file *file, unsigned long arg)
+{
+	struct inode *inode = file_inode(file);
+	struct super_block *sb = inode->i_sb;
+	struct scoutfs_ioctl_stage_fd args;
+	struct file *src;
+	long ret;
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+
+	trace_scoutfs_ioc_stage_fd(sb, scoutfs_ino(inode), &args);
+
+	/* verify arg constraints that aren't dependent on file */
+	if ((args.offset + args.length < args.offset) ||
+	    (args.from_off + args.length < args.from_off) ||
+	    (args.offset + args.length > LLONG_MAX) ||
+	    (args.from_off + args.length > LLONG_MAX) ||
+	    args.offset & SCOUTFS_BLOCK_SM_MASK) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	/* fget() takes an unsigned int, don't truncate to another fd */
+	if (args.from_fd > INT_MAX) {
+		ret = -EBADF;
+		goto out;
+	}
+
+	if (args.length == 0) {
+		ret = 0;
+		goto out;
+	}
+
+	src = fget(args.from_fd);
+	if (!src) {
+		ret = -EBADF;
+		goto out;
+	}
+
+	if (!(src->f_mode & FMODE_READ)) {
+		ret = -EBADF;
+		goto out_put;
+	}
+
+	if (file_inode(src)->i_sb->s_magic == sb->s_magic) {
+		ret = -EINVAL;
+		goto out_put;
+	}
+
+	if (!S_ISREG(file_inode(src)->i_mode) || !src->f_op->splice_read) {
+		ret = -EOPNOTSUPP;
+		goto out_put;
+	}
+
+	/* a short source would stage a partial region, maybe mid-block */
+	if (args.from_off + args.length > i_size_read(file_inode(src))) {
+		ret = -EINVAL;
+		goto out_put;
+	}
+
+	ret = stage_locked(file, args.data_version, args.offset, args.length,
+			   NULL, src, args.from_off);
+out_put:
+	fput(src);
+out:
+	trace_scoutfs_ioc_stage_ret(sb, scoutfs_ino(inode), ret);
+	return ret;
+}
+
+/*
+ * Batches are read and processed in chunks, each sorted by inode
+ * number.  Files in the same inode lock group are then processed
+ * together and their lock acquisitions find the cached lock from the
+ * previous file instead of each requesting it from the server.
+ */
+#define BATCH_CHUNK_NR 256
+
+struct batch_order {
+	u64 ino;
+	unsigned int ind;
+};
+
+static int cmp_batch_order(const void *A, const void *B)
+{
+	const struct batch_order *a = A;
+	const struct batch_order *b = B;
+
+	return scoutfs_cmp_u64s(a->ino, b->ino) ?:
+	       scoutfs_cmp(a->ind, b->ind);
+}
+
+static long release_batch_entry(struct super_block *sb,
+				struct scoutfs_ioctl_batch_entry *ent)
+{
+	struct inode *inode;
+	long ret;
+
+	if (ent->length == 0)
+		return 0;
+	if (invalid_release_range(ent->offset, ent->length))
+		return -EINVAL;
+
+	inode = scoutfs_iget(sb, ent->ino, 0, SCOUTFS_IGF_LINKED);
+	if (IS_ERR(inode))
+		return PTR_ERR(inode);
+
+	ret = release_inode(inode, ent->data_version, ent->offset,
+			    ent->length);
+	iput(inode);
+
+	return ret;
+}
+
+/*
+ * Staging writes through the page cache which wants a file, so we open
+ * a file for the inode much like open_by_handle_at() would.
+ */
+static long stage_batch_entry(struct file *file,
+			      struct scoutfs_ioctl_batch_entry *ent)
+{
+	struct super_block *sb = file_inode(file)->i_sb;
+	struct path path = { .mnt = file->f_path.mnt };
+	struct file *sfile;
+	struct inode *inode;
+	struct iovec iov;
+	long ret;
+
+	if ((ent->offset + ent->length < ent->offset) ||
+	    (ent->offset + ent->length > LLONG_MAX) ||
+	    (ent->length > MAX_RW_COUNT) ||
+	    (ent->offset & SCOUTFS_BLOCK_SM_MASK))
+		return -EINVAL;
+
+	if (ent->length == 0)
+		return 0;
+
+	inode = scoutfs_iget(sb, ent->ino, 0, SCOUTFS_IGF_LINKED);
+	if (IS_ERR(inode))
+		return PTR_ERR(inode);
+
+	/* don't open directories and the like for writing */
+	if (!S_ISREG(inode->i_mode)) {
+		iput(inode);
+		return -EINVAL;
+	}
+
+	/* consumes the inode reference */
+	path.dentry = d_obtain_alias(inode);
+	if (IS_ERR(path.dentry))
+		return PTR_ERR(path.dentry);
+
+	sfile = dentry_open(&path, O_WRONLY | O_LARGEFILE, current_cred());
+	dput(path.dentry);
+	if (IS_ERR(sfile))
+		return PTR_ERR(sfile);
+
+	iov.iov_base = (void __user *)(unsigned long)ent->buf_ptr;
+	iov.iov_len = ent->length;
+
+	ret = stage_locked(sfile, ent->data_version, ent->offset, ent->length,
+			   &iov, NULL, 0);
+	fput(sfile);
+
+	return ret;
+}
+
+static long batch_ioctl(struct file *file, unsigned long arg, bool stage)
+{
+	struct super_block *sb = file_inode(file)->i_sb;
+	struct scoutfs_ioctl_batch_entry __user *uents;
+	struct scoutfs_ioctl_batch_entry *ents = NULL;
+	struct batch_order *order = NULL;
+	struct scoutfs_ioctl_batch args;
+	s64 result;
+	u64 done = 0;
+	long ret;
+	int nr;
+	int ind;
+	int i;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (copy_from_user(&args, (void __user *)arg, sizeof(args)))
+		return -EFAULT;
+
+	if (args.flags & SCOUTFS_IOC_BATCH_FLAGS_UNKNOWN)
+		return -EINVAL;
+
+	if (args.ents_nr > LONG_MAX)
+		return -EINVAL;
+
+	uents = (void __user *)(unsigned long)args.ents_ptr;
+
+	ents = kmalloc_array(BATCH_CHUNK_NR, sizeof(ents[0]), GFP_KERNEL);
+	order = kmalloc_array(BATCH_CHUNK_NR, sizeof(order[0]), GFP_KERNEL);
+	if (!ents || !order) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	ret = mnt_want_write_file(file);
+	if (ret)
+		goto out;
+
+	while (done < args.ents_nr) {
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			break;
+		}
+
+		nr = min_t(u64, args.ents_nr - done, BATCH_CHUNK_NR);
+
+		if (copy_from_user(ents, &uents[done], nr * sizeof(ents[0]))) {
+			ret = -EFAULT;
+			break;
+		}
+
+		for (i = 0; i < nr; i++) {
+			order[i].ino = ents[i].ino;
+			order[i].ind = i;
+		}
+		sort(order, nr, sizeof(order[0]), cmp_batch_order, NULL);
+
+		for (i = 0; i < nr; i++) {
+			ind = order[i].ind;
+
+			if (stage)
+				result = stage_batch_entry(file, &ents[ind]);
+			else
+				result = release_batch_entry(sb, &ents[ind]);
+
+			if (put_user(result, &uents[done + ind].result)) {
+				ret = -EFAULT;
+				break;
+			}
+		}
+		if (ret < 0)
+			break;
+
+		if (stage)
+			scoutfs_add_counter(sb, ioctl_stage_batch_ents, nr);
+		else
+			scoutfs_add_counter(sb, ioctl_release_batch_ents, nr);
+		done += nr;
+	}
+
+	mnt_drop_write_file(file);
+out:
+	kfree(ents);
+	kfree(order);
+
+	return done ?: ret;
+}
+
+static long scoutfs_ioc_release_batch(struct file *file, unsigned long arg)
+{
+	return batch_ioctl(file, arg, false);
+}
+
+static long scoutfs_ioc_stage_batch(struct file *file, unsigned long arg)
+{
+	return batch_ioctl(file, arg, true);
+}
+
 static long scoutfs_ioc_stat_more(struct file *file, unsigned long arg)
 {
 	struct inode *inode = file_inode(file);
@@ -611,6 +926,20 @@ static long scoutfs_ioc_data_waiting(struct file *file, unsigned long arg)
 	return ret ?: total;
 }
 
+static long scoutfs_ioc_data_waiting_events(struct file *file,
+					    unsigned long arg)
+{
+	struct scoutfs_ioctl_data_waiting_events dwev;
+
+	if (copy_from_user(&dwev, (void __user *)arg, sizeof(dwev)))
+		return -EFAULT;
+
+	if (dwev.flags & SCOUTFS_IOC_DATA_WAITING_EVENTS_FLAGS_UNKNOWN)
+		return -EINVAL;
+
+	return scoutfs_data_waiting_events_fd(file);
+}
+
 /*
  * This is used when restoring files, it lets the caller set all the
  * inode attributes which are otherwise unreachable.  Changing the file
@@ -1504,6 +1833,381 @@ out:
 	return nr ?: ret;
 }
 
+static void inode_item_attrs(struct scoutfs_ioctl_inode_attrs *attrs, u64 ino,
+			     struct scoutfs_inode *sinode)
+{
+	*attrs = (struct scoutfs_ioctl_inode_attrs) {
+		.ino = ino,
+		.size = le64_to_cpu(sinode->size),
+		.meta_seq = le64_to_cpu(sinode->meta_seq),
+		.data_seq = le64_to_cpu(sinode->data_seq),
+		.data_version = le64_to_cpu(sinode->data_version),
+		.online_blocks = le64_to_cpu(sinode->online_blocks),
+		.offline_blocks = le64_to_cpu(sinode->offline_blocks),
+		.atime_sec = le64_to_cpu(sinode->atime.sec),
+		.mtime_sec = le64_to_cpu(sinode->mtime.sec),
+		.ctime_sec = le64_to_cpu(sinode->ctime.sec),
+		.crtime_sec = le64_to_cpu(sinode->crtime.sec),
+		.atime_nsec = le32_to_cpu(sinode->atime.nsec),
+		.mtime_nsec = le32_to_cpu(sinode->mtime.nsec),
+		.ctime_nsec = le32_to_cpu(sinode->ctime.nsec),
+		.crtime_nsec = le32_to_cpu(sinode->crtime.nsec),
+		.nlink = le32_to_cpu(sinode->nlink),
+		.uid = le32_to_cpu(sinode->uid),
+		.gid = le32_to_cpu(sinode->gid),
+		.mode = le32_to_cpu(sinode->mode),
+		.rdev = le32_to_cpu(sinode->rdev),
+	};
+}
+
+/*
+ * Readdir plus reads a batch of entries under the directory lock and
+ * then reads the entries' inode items in inode order, instead of
+ * instantiating vfs inodes.  Entries in a directory tend to have nearby
+ * inode numbers so each inode group lock is acquired once for many
+ * entries.  Only one lock is held at a time so we don't have to worry
+ * about ordering the directory and inode locks.
+ */
+#define READDIR_PLUS_BATCH 64
+
+struct readdir_plus_ent {
+	struct scoutfs_readdir_entry *ent;
+	struct scoutfs_inode sinode;
+	bool found;
+};
+
+static int cmp_readdir_plus_ino(const void *A, const void *B)
+{
+	const struct readdir_plus_ent *a = *(const struct readdir_plus_ent **)A;
+	const struct readdir_plus_ent *b = *(const struct readdir_plus_ent **)B;
+
+	return scoutfs_cmp_u64s(a->ent->ino, b->ent->ino);
+}
+
+/*
+ * Read the inode items for entries that are sorted by inode number.
+ * Inodes that have been deleted since their entry was read aren't
+ * found and are skipped by the caller.
+ */
+static int read_readdir_plus_inodes(struct super_block *sb, struct readdir_plus_ent **sorted,
+				    int nr)
+{
+	struct scoutfs_lock *lock = NULL;
+	struct readdir_plus_ent *rpe;
+	struct scoutfs_key key;
+	u64 group = 0;
+	u64 ino;
+	int ret = 0;
+	int i;
+
+	for (i = 0; i < nr; i++) {
+		rpe = sorted[i];
+		ino = rpe->ent->ino;
+
+		if (lock && (ino & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK) != group) {
+			scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+			lock = NULL;
+		}
+
+		if (!lock) {
+			ret = scoutfs_lock_ino(sb, SCOUTFS_LOCK_READ, 0, ino, &lock);
+			if (ret < 0)
+				goto out;
+			group = ino & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK;
+		}
+
+		scoutfs_inode_init_key(&key, ino);
+		ret = scoutfs_item_lookup_exact(sb, &key, &rpe->sinode, sizeof(rpe->sinode), lock);
+		if (ret < 0 && ret != -ENOENT)
+			goto out;
+
+		rpe->found = (ret == 0);
+		ret = 0;
+	}
+
+out:
+	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+	return ret;
+}
+
+static long scoutfs_ioc_readdir_plus(struct file *file, unsigned long arg)
+{
+	struct inode *inode = file_inode(file);
+	struct super_block *sb = inode->i_sb;
+	struct scoutfs_ioctl_readdir_plus __user *urdp = (void __user *)arg;
+	struct scoutfs_ioctl_readdir_plus_entry __user *uent;
+	struct scoutfs_ioctl_readdir_plus_entry rpent;
+	struct scoutfs_ioctl_readdir_plus rdp;
+	struct readdir_plus_ent **sorted = NULL;
+	struct readdir_plus_ent *rpes = NULL;
+	struct scoutfs_readdir_entry *ent;
+	struct scoutfs_readdir_entry *tmp;
+	LIST_HEAD(list);
+	u64 copied = 0;
+	long nr = 0;
+	int count;
+	int bytes;
+	int ret;
+	int i;
+
+	if (!S_ISDIR(inode->i_mode))
+		return -ENOTDIR;
+
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+
+	ret = inode_permission(inode, MAY_EXEC);
+	if (ret < 0)
+		return ret;
+
+	if (copy_from_user(&rdp, urdp, sizeof(rdp)))
+		return -EFAULT;
+
+	if ((rdp.flags & SCOUTFS_IOC_READDIR_PLUS_FLAGS_UNKNOWN) ||
+	    (rdp.entries_ptr & 15))
+		return -EINVAL;
+
+	rpes = kmalloc_array(READDIR_PLUS_BATCH, sizeof(rpes[0]), GFP_KERNEL);
+	sorted = kmalloc_array(READDIR_PLUS_BATCH, sizeof(sorted[0]), GFP_KERNEL);
+	if (!rpes || !sorted) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	uent = (void __user *)(unsigned long)rdp.entries_ptr;
+
+	while (rdp.pos <= SCOUTFS_DIRENT_LAST_POS) {
+		/* don't read many more entries than could fit */
+		count = min_t(u64, READDIR_PLUS_BATCH,
+			      (rdp.entries_bytes - copied) / sizeof(rpent));
+		if (count == 0) {
+			ret = nr ? 0 : -EINVAL;
+			goto out;
+		}
+
+		ret = scoutfs_dir_add_next_readdir_ents(sb, inode, rdp.pos, count, &list);
+		if (ret <= 0)
+			goto out;
+
+		count = 0;
+		list_for_each_entry(ent, &list, head) {
+			rpes[count].ent = ent;
+			sorted[count] = &rpes[count];
+			count++;
+		}
+
+		sort(sorted, count, sizeof(sorted[0]), cmp_readdir_plus_ino, NULL);
+		ret = read_readdir_plus_inodes(sb, sorted, count);
+		if (ret < 0)
+			goto out;
+
+		for (i = 0; i < count; i++) {
+			ent = rpes[i].ent;
+
+			if (rpes[i].found) {
+				bytes = ALIGN(offsetof(struct scoutfs_ioctl_readdir_plus_entry,
+						       name[ent->name_len + 1]), 16);
+				if (copied + bytes > rdp.entries_bytes) {
+					ret = nr ? 0 : -EINVAL;
+					goto out;
+				}
+
+				rpent = (struct scoutfs_ioctl_readdir_plus_entry) {
+					.pos = ent->pos,
+					.entry_bytes = bytes,
+					.d_type = ent->d_type,
+					.name_len = ent->name_len,
+				};
+				inode_item_attrs(&rpent.attrs, ent->ino, &rpes[i].sinode);
+
+				if (copy_to_user(uent, &rpent, sizeof(rpent)) ||
+				    copy_to_user(&uent->name[0], ent->name, ent->name_len) ||
+				    put_user('\0', &uent->name[ent->name_len])) {
+					ret = -EFAULT;
+					goto out;
+				}
+
+				uent = (void __user *)uent + bytes;
+				copied += bytes;
+				nr++;
+			}
+
+			rdp.pos = ent->pos + 1;
+		}
+
+		list_for_each_entry_safe(ent, tmp, &list, head) {
+			list_del(&ent->head);
+			kfree(ent);
+		}
+	}
+
+	ret = 0;
+out:
+	list_for_each_entry_safe(ent, tmp, &list, head) {
+		list_del(&ent->head);
+		kfree(ent);
+	}
+	kfree(sorted);
+	kfree(rpes);
+
+	/* return the entries that were copied before a later error */
+	if ((ret == 0 || nr > 0) && put_user(rdp.pos, &urdp->pos)) {
+		ret = -EFAULT;
+		nr = 0;
+	}
+
+	scoutfs_add_counter(sb, ioctl_readdir_plus_ents, nr);
+
+	return nr ?: ret;
+}
+
+/*
+ * Iterate over the fs items in each inode group, copying out the
+ * attributes of the inode items we find.  The first item of each inode
+ * is its inode item so we can skip to the next inode number after each
+ * item that we see.  We skip empty regions of the inode number space by
+ * searching for the next persistent item after each group, like
+ * _WALK_INODES.
+ *
+ * Like _WALK_INODES this is copying to userspace while holding a read
+ * lock, which is safe because cluster locks don't block local tasks.
+ */
+static long scoutfs_ioc_get_inode_attrs(struct file *file, unsigned long arg)
+{
+	struct super_block *sb = file_inode(file)->i_sb;
+	struct scoutfs_ioctl_get_inode_attrs __user *ugia = (void __user *)arg;
+	struct scoutfs_ioctl_inode_attrs __user *uattrs;
+	struct scoutfs_ioctl_get_inode_attrs gia;
+	struct scoutfs_ioctl_inode_attrs attrs;
+	struct scoutfs_lock *lock = NULL;
+	struct scoutfs_inode sinode;
+	struct scoutfs_key next_key;
+	struct scoutfs_key last_key;
+	struct scoutfs_key key;
+	bool empty;
+	bool done;
+	long nr = 0;
+	u64 ino;
+	int ret;
+
+	if (!(file->f_mode & FMODE_READ))
+		return -EBADF;
+
+	if (!capable(CAP_SYS_ADMIN))
+		return -EPERM;
+
+	if (copy_from_user(&gia, ugia, sizeof(gia)))
+		return -EFAULT;
+
+	if ((gia.flags & SCOUTFS_IOC_GET_INODE_ATTRS_FLAGS_UNKNOWN) ||
+	    (gia.attrs_ptr & (sizeof(__u64) - 1)))
+		return -EINVAL;
+
+	uattrs = (void __user *)(unsigned long)gia.attrs_ptr;
+	gia.attrs_nr = min_t(u64, gia.attrs_nr, LONG_MAX);
+	scoutfs_inode_init_key(&last_key, gia.last_ino);
+	done = gia.first_ino > gia.last_ino;
+	ret = 0;
+
+	while (!done && nr < gia.attrs_nr) {
+		ret = scoutfs_lock_ino(sb, SCOUTFS_LOCK_READ, 0, gia.first_ino, &lock);
+		if (ret < 0)
+			goto out;
+
+		scoutfs_inode_init_key(&key, gia.first_ino);
+		empty = false;
+
+		while (nr < gia.attrs_nr) {
+			ret = scoutfs_item_next(sb, &key, &last_key, &sinode, sizeof(sinode), lock);
+			if (ret == -ENOENT) {
+				empty = true;
+				break;
+			}
+			if (ret < 0)
+				goto out;
+
+			/* fs items are keyed by their inode number in _first */
+			ino = le64_to_cpu(key._sk_first);
+
+			if (key.sk_type == SCOUTFS_INODE_TYPE) {
+				if (ret != sizeof(sinode)) {
+					ret = -EIO;
+					goto out;
+				}
+
+				if (le64_to_cpu(sinode.meta_seq) >= gia.min_meta_seq &&
+				    le64_to_cpu(sinode.data_seq) >= gia.min_data_seq) {
+					inode_item_attrs(&attrs, ino, &sinode);
+					if (copy_to_user(uattrs, &attrs, sizeof(attrs))) {
+						ret = -EFAULT;
+						goto out;
+					}
+					uattrs++;
+					nr++;
+				}
+			}
+
+			if (ino >= gia.last_ino) {
+				done = true;
+				break;
+			}
+
+			gia.first_ino = ino + 1;
+			scoutfs_inode_init_key(&key, gia.first_ino);
+		}
+
+		if (empty) {
+			/* continue after the group's locked key range */
+			key = lock->end;
+			scoutfs_key_inc(&key);
+		}
+
+		scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+		lock = NULL;
+		ret = 0;
+
+		if (!empty)
+			continue;
+
+		if (fatal_signal_pending(current)) {
+			ret = -EINTR;
+			goto out;
+		}
+
+		if (scoutfs_key_compare(&key, &last_key) <= 0)
+			ret = scoutfs_forest_next_hint(sb, &key, &next_key);
+		else
+			ret = -ENOENT;
+		if (ret < 0 && ret != -ENOENT)
+			goto out;
+
+		if (ret == -ENOENT || scoutfs_key_compare(&next_key, &last_key) > 0) {
+			done = true;
+			ret = 0;
+			break;
+		}
+
+		gia.first_ino = le64_to_cpu(next_key._sk_first);
+	}
+
+	/* inode U64_MAX is never allocated, don't wrap back to 0 */
+	if (done)
+		gia.first_ino = max(gia.first_ino, gia.last_ino == U64_MAX ? U64_MAX :
+						   gia.last_ino + 1);
+out:
+	scoutfs_unlock(sb, lock, SCOUTFS_LOCK_READ);
+
+	/* return the attributes that were copied before a later error */
+	if ((ret == 0 || nr > 0) && put_user(gia.first_ino, &ugia->first_ino)) {
+		ret = -EFAULT;
+		nr = 0;
+	}
+
+	scoutfs_add_counter(sb, ioctl_get_inode_attrs_ents, nr);
+
+	return nr ?: ret;
+}
+
 long scoutfs_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 {
 	switch (cmd) {
@@ -1515,10 +2219,18 @@ long scoutfs_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		return scoutfs_ioc_release(file, arg);
 	case SCOUTFS_IOC_STAGE:
 		return scoutfs_ioc_stage(file, arg);
+	case SCOUTFS_IOC_STAGE_FD:
+		return scoutfs_ioc_stage_fd(file, arg);
+	case SCOUTFS_IOC_RELEASE_BATCH:
+		return scoutfs_ioc_release_batch(file, arg);
+	case SCOUTFS_IOC_STAGE_BATCH:
+		return scoutfs_ioc_stage_batch(file, arg);
 	case SCOUTFS_IOC_STAT_MORE:
 		return scoutfs_ioc_stat_more(file, arg);
 	case SCOUTFS_IOC_DATA_WAITING:
 		return scoutfs_ioc_data_waiting(file, arg);
+	case SCOUTFS_IOC_DATA_WAITING_EVENTS:
+		return scoutfs_ioc_data_waiting_events(file, arg);
 	case SCOUTFS_IOC_SETATTR_MORE:
 		return scoutfs_ioc_setattr_more(file, arg);
 	case SCOUTFS_IOC_LISTXATTR_HIDDEN:
@@ -1541,6 +2253,10 @@ long scoutfs_ioctl(struct file *file, unsigned int cmd, unsigned long arg)
 		return scoutfs_ioc_get_allocated_inos(file, arg);
 	case SCOUTFS_IOC_GET_REFERRING_ENTRIES:
 		return scoutfs_ioc_get_referring_entries(file, arg);
+	case SCOUTFS_IOC_READDIR_PLUS:
+		return scoutfs_ioc_readdir_plus(file, arg);
+	case SCOUTFS_IOC_GET_INODE_ATTRS:
+		return scoutfs_ioc_get_inode_attrs(file, arg);
 	}
 
 	return -ENOTTY;
@@ -256,6 +256,72 @@ struct scoutfs_ioctl_data_waiting {
 #define SCOUTFS_IOC_DATA_WAITING _IOW(SCOUTFS_IOCTL_MAGIC, 6, \
 				      struct scoutfs_ioctl_data_waiting)
 
+/*
+ * Return a file descriptor that delivers events as tasks start waiting
+ * for offline data.  Each read returns as many
+ * scoutfs_ioctl_data_waiting_entry structs as fit in the buffer.  Reads
+ * block until an event arrives unless the descriptor is non-blocking,
+ * and the descriptor can be used with poll, select, and epoll.
+ *
+ * Only waiters that arrive after the descriptor is created generate
+ * events.  Callers should create the descriptor and then iterate over
+ * the existing waiters with _DATA_WAITING.  Events are queued per
+ * descriptor and are dropped if the reader falls behind.  The next read
+ * after dropped events returns -EOVERFLOW and callers should iterate
+ * over all the waiters again.
+ *
+ * The returned descriptor holds a reference to the mount.
+ */
+struct scoutfs_ioctl_data_waiting_events {
+	__u64 flags;
+};
+
+#define SCOUTFS_IOC_DATA_WAITING_EVENTS_FLAGS_UNKNOWN	(U64_MAX << 0)
+
+#define SCOUTFS_IOC_DATA_WAITING_EVENTS \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 19, struct scoutfs_ioctl_data_waiting_events)
+
+/*
+ * Release or stage regions of many files in one call.  The files are
+ * identified by their inode numbers so the ioctl can be called on any
+ * file in the file system, typically the root directory, without
+ * opening each file.  Callers must have CAP_SYS_ADMIN.
+ *
+ * Each entry is processed as though _RELEASE or _STAGE were called on
+ * the file with the entry's data_version, offset, and length.  Stage
+ * entries copy the file contents from the buffer at buf_ptr, it's
+ * ignored for release.  Entries are processed in inode number order,
+ * not the order they're given in, so that files that share cluster
+ * locks are processed together.
+ *
+ * The result of each entry is stored in its result field: 0 or the
+ * number of bytes staged on success, or a negative errno.  Failing
+ * entries don't stop processing of the rest of the entries.  The ioctl
+ * returns the number of entries that were processed, or an error if
+ * none could be.
+ */
+struct scoutfs_ioctl_batch_entry {
+	__u64 ino;
+	__u64 data_version;
+	__u64 offset;
+	__u64 length;
+	__u64 buf_ptr;
+	__s64 result;
+};
+
+struct scoutfs_ioctl_batch {
+	__u64 ents_ptr;
+	__u64 ents_nr;
+	__u64 flags;
+};
+
+#define SCOUTFS_IOC_BATCH_FLAGS_UNKNOWN	(U64_MAX << 0)
+
+#define SCOUTFS_IOC_RELEASE_BATCH \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 20, struct scoutfs_ioctl_batch)
+#define SCOUTFS_IOC_STAGE_BATCH \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 21, struct scoutfs_ioctl_batch)
+
 /*
  * If i_size is set then data_version must be non-zero.  If the offline
  * flag is set then i_size must be set and a offline extent will be
@@ -673,4 +739,174 @@ struct scoutfs_ioctl_dirent {
 #define SCOUTFS_IOC_GET_REFERRING_ENTRIES \
 	_IOW(SCOUTFS_IOCTL_MAGIC, 17, struct scoutfs_ioctl_get_referring_entries)
 
+/*
+ * Stage file contents from another open file instead of from a user
+ * buffer.  The source file's pages are spliced into the staged file's
+ * page cache so the data is copied once in the kernel rather than being
+ * read into and then written from a user buffer.
+ *
+ * All the constraints of _STAGE apply to the staged region of the file
+ * that the ioctl is called on.  The source must be open for reading,
+ * must support splice, and can't be in a scoutfs file system.  Use
+ * _MOVE_BLOCKS with _MB_STAGE to stage from files in scoutfs.  The
+ * source must contain the full length from from_off, -EINVAL is
+ * returned if it ends before then.
+ *
+ * Returns the length once it has all been staged.  Returns -EIO if the
+ * source was truncated while it was being staged.  Returns -EOPNOTSUPP
+ * if the source isn't a regular file that can be spliced, callers can
+ * fall back to reading and _STAGE.
+ */
+struct scoutfs_ioctl_stage_fd {
+	__u64 data_version;
+	__u64 from_fd;
+	__u64 from_off;
+	__u64 offset;
+	__u64 length;
+};
+
+#define SCOUTFS_IOC_STAGE_FD \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 18, struct scoutfs_ioctl_stage_fd)
+
+/*
+ * The attributes of an inode as they're stored in its inode item.
+ * These are the fields that stat(2) and _STAT_MORE would return.
+ * st_blocks can be derived from the sum of the online and offline
+ * blocks, which are in units of 4KB blocks.
+ */
+struct scoutfs_ioctl_inode_attrs {
+	__u64 ino;
+	__u64 size;
+	__u64 meta_seq;
+	__u64 data_seq;
+	__u64 data_version;
+	__u64 online_blocks;
+	__u64 offline_blocks;
+	__u64 atime_sec;
+	__u64 mtime_sec;
+	__u64 ctime_sec;
+	__u64 crtime_sec;
+	__u32 atime_nsec;
+	__u32 mtime_nsec;
+	__u32 ctime_nsec;
+	__u32 crtime_nsec;
+	__u32 nlink;
+	__u32 uid;
+	__u32 gid;
+	__u32 mode;
+	__u32 rdev;
+	__u8  _pad[4];
+};
+
+/*
+ * Read a directory's entries along with the attributes of the inodes
+ * they refer to.  This is equivalent to reading the directory and
+ * calling stat on each entry, without having to instantiate each
+ * inode.  The ioctl is called on an open directory and the caller needs
+ * search permission on the directory, as stat would.
+ *
+ * @pos: The readdir f_pos position to start reading from.  0 starts
+ * from the first entry.  It's updated to the position after the last
+ * entry that was stored in the buffer so that repeated calls continue
+ * iteration.  The . and .. entries aren't returned.
+ *
+ * @entries_ptr: A pointer to the buffer where entries are stored.  It
+ * must be aligned to 16 bytes.
+ *
+ * @entries_bytes: The size of the entries buffer.
+ *
+ * Returns the number of entries stored in the buffer, 0 once there are
+ * no more entries.  EINVAL is returned if the buffer isn't aligned or
+ * can't hold the next entry.  Entries are iterated over by advancing by
+ * each entry's entry_bytes.
+ *
+ * Like readdir and stat, the entries and attributes returned can
+ * reflect racing modification.  Each attribute struct was current when
+ * it was read, and entries whose inodes were deleted after the entry
+ * was read are skipped.
+ */
+struct scoutfs_ioctl_readdir_plus {
+	__u64 pos;
+	__u64 entries_ptr;
+	__u64 entries_bytes;
+	__u64 flags;
+};
+
+#define SCOUTFS_IOC_READDIR_PLUS_FLAGS_UNKNOWN	(U64_MAX << 0)
+
+/*
+ * @pos: The readdir f_pos position of the entry.
+ *
+ * @entry_bytes: The total bytes taken by the entry, including the
+ * name and alignment padding.
+ *
+ * @d_type: Inode type as specified with DT_ enum values in readdir(3).
+ *
+ * @name_len: The number of bytes in the name not including the
+ * trailing null.
+ *
+ * @name: The null terminated name of the entry.
+ */
+struct scoutfs_ioctl_readdir_plus_entry {
+	struct scoutfs_ioctl_inode_attrs attrs;
+	__u64 pos;
+	__u16 entry_bytes;
+	__u8  d_type;
+	__u8  name_len;
+	__u8  name[4];
+};
+
+#define SCOUTFS_IOC_READDIR_PLUS \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 22, struct scoutfs_ioctl_readdir_plus)
+
+/*
+ * Return the attributes of all the inodes in a range of inode numbers.
+ * The attributes are read directly from inode items in inode number
+ * order without instantiating vfs inodes.  This is the bulk equivalent
+ * of calling stat and _STAT_MORE on every inode and is meant for
+ * policy engines that scan the whole file system.  It requires
+ * CAP_SYS_ADMIN.
+ *
+ * @first_ino: The first inode number to return.  It's updated to the
+ * next inode number to scan so that repeated calls continue iteration.
+ *
+ * @last_ino: The last inode number that can be returned.
+ *
+ * @min_meta_seq, @min_data_seq: Only inodes whose meta_seq and
+ * data_seq are at least these values are returned.  0 returns all
+ * inodes.  An inode's meta_seq changes whenever it's modified so
+ * incremental scans can set min_meta_seq to the committed_seq from
+ * statfs_more before their previous scan.
+ *
+ * @attrs_ptr: A pointer to an aligned array of attribute structs.
+ *
+ * @attrs_nr: The number of attribute structs in the array.
+ *
+ * Returns the number of attribute structs that were filled, 0 once
+ * there are no more inodes in the range.  A call can return fewer
+ * attributes than fit while there are still inodes left in the range.
+ * Iteration is done when a call returns 0.
+ *
+ * Like _WALK_INODES, sparse regions of the inode number space are
+ * skipped by looking for persistent items.  Inodes that were created
+ * in regions that were empty in the most recently committed
+ * transaction might not be returned until the transaction is synced.
+ * Each attribute struct was current when it was read but inodes can be
+ * created, modified, or deleted as the scan proceeds.
+ */
+struct scoutfs_ioctl_get_inode_attrs {
+	__u64 first_ino;
+	__u64 last_ino;
+	__u64 min_meta_seq;
+	__u64 min_data_seq;
+	__u64 attrs_ptr;
+	__u64 attrs_nr;
+	__u64 flags;
+};
+
+#define SCOUTFS_IOC_GET_INODE_ATTRS_FLAGS_UNKNOWN	(U64_MAX << 0)
+
+#define SCOUTFS_IOC_GET_INODE_ATTRS \
+	_IOW(SCOUTFS_IOCTL_MAGIC, 23, struct scoutfs_ioctl_get_inode_attrs)
+
 #endif
@@ -1849,12 +1849,18 @@ out:
  * operating on behalf of.  Callers can optionally provide that primary
  * lock to get the version from.   This ensures that items created under
  * WRITE_ONLY locks can not have versions less than their primary data.
+ *
+ * All item modifications get their seq here so we also record that the
+ * lock has dirtied items.  The lock server is told when write locks
+ * are invalidated without having modified items.
  */
 static u64 item_seq(struct super_block *sb, struct scoutfs_lock *lock,
 		    struct scoutfs_lock *primary)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
 
+	WRITE_ONCE(lock->items_dirtied, true);
+
 	return max3(sbi->trans_seq, lock->write_seq, primary ? primary->write_seq : 0);
 }
 
@@ -2464,6 +2470,51 @@ bool scoutfs_item_range_cached(struct super_block *sb,
 	return cached;
 }
 
+/*
+ * Return the number of cached items in the given range.  This is only
+ * used for statistics as locks decide to keep or drop their items.
+ */
+u64 scoutfs_item_range_count(struct super_block *sb, struct scoutfs_key *start,
+			     struct scoutfs_key *end)
+{
+	DECLARE_ITEM_CACHE_INFO(sb, cinf);
+	struct cached_item *item;
+	struct cached_item *next;
+	struct cached_page *pg;
+	struct cached_page *pg_next;
+	struct scoutfs_key pos;
+	u64 nr = 0;
+
+	pos = *start;
+
+	read_lock(&cinf->rwlock);
+
+	while (scoutfs_key_compare(&pos, end) <= 0) {
+		pg = page_rbtree_walk(sb, &cinf->pg_root, &pos, &pos, NULL, &pg_next,
+				      NULL, NULL) ?: pg_next;
+		if (!pg || scoutfs_key_compare(&pg->start, end) > 0)
+			break;
+
+		read_lock(&pg->rwlock);
+		for (item = item_rbtree_walk(&pg->item_root, &pos, &next, NULL, NULL) ?: next;
+		     item && scoutfs_key_compare(&item->key, end) <= 0;
+		     item = next_item(item)) {
+			if (!item->deletion)
+				nr++;
+		}
+		pos = pg->end;
+		read_unlock(&pg->rwlock);
+
+		if (scoutfs_key_compare(&pos, end) >= 0)
+			break;
+		scoutfs_key_inc(&pos);
+	}
+
+	read_unlock(&cinf->rwlock);
+
+	return nr;
+}
+
 /*
  * Remove the cached items in the given range.  We drop pages that are
  * fully inside the range and trim any pages that intersect it.  This is
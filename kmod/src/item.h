@@ -31,6 +31,8 @@ int scoutfs_item_write_done(struct super_block *sb);
 bool scoutfs_item_range_cached(struct super_block *sb,
 			       struct scoutfs_key *start,
 			       struct scoutfs_key *end, bool *dirty);
+u64 scoutfs_item_range_count(struct super_block *sb, struct scoutfs_key *start,
+			     struct scoutfs_key *end);
 void scoutfs_item_invalidate(struct super_block *sb, struct scoutfs_key *start,
 			     struct scoutfs_key *end);
 
@@ -273,4 +273,8 @@ ssize_t kc_generic_file_buffered_write(struct kiocb *iocb, const struct iovec *i
 #define generic_file_buffered_write kc_generic_file_buffered_write
 #endif
 
+#ifndef KC_POLL_T
+typedef unsigned __poll_t;
+#endif
+
 #endif
@@ -18,6 +18,7 @@
 #include <linux/sort.h>
 #include <linux/ctype.h>
 #include <linux/posix_acl.h>
+#include <linux/hash.h>
 
 #include "super.h"
 #include "lock.h"
@@ -25,6 +26,7 @@
 #include "msg.h"
 #include "cmp.h"
 #include "inode.h"
+#include "dir.h"
 #include "trans.h"
 #include "counters.h"
 #include "endian_swap.h"
@@ -36,6 +38,8 @@
 #include "item.h"
 #include "omap.h"
 #include "util.h"
+#include "hash.h"
+#include "options.h"
 
 /*
  * scoutfs uses a lock service to manage item cache consistency between
@@ -67,33 +71,73 @@
  * relative to that lock state we resend.
  */
 
+/*
+ * Locks are spread across shards by the hash of their start key.  Each
+ * shard's spinlock protects the state of the locks in the shard as well
+ * as the shard's tree, lru, and lists of locks that have pending work.
+ * Lock calls on keys in different shards don't contend with each other
+ * or with grant responses, invalidation, and shrinking of other shards.
+ *
+ * The range tree only exists to catch overlapping locks so it's shared
+ * by all the shards with its own lock that's only used as locks are
+ * inserted and removed.  It nests inside shard locks.
+ */
+#define LOCK_SHARD_SHIFT	6
+#define LOCK_SHARD_NR		(1 << LOCK_SHARD_SHIFT)
+
+struct lock_shard {
+	spinlock_t lock;
+	struct rb_root lock_tree;
+	struct list_head lru_list;
+	unsigned long lru_nr;
+	struct list_head inv_list;
+	struct list_head shrink_list;
+} ____cacheline_aligned_in_smp;
+
 /*
  * allocated per-super, freed on unmount.
  */
 struct lock_info {
 	struct super_block *sb;
-	spinlock_t lock;
 	bool shutdown;
 	bool unmounting;
-	struct rb_root lock_tree;
+	spinlock_t range_lock;
 	struct rb_root lock_range_tree;
 	KC_DEFINE_SHRINKER(shrinker);
-	struct list_head lru_list;
-	unsigned long long lru_nr;
+	atomic_long_t lru_nr;
+	unsigned int next_shrink_shard;
 	struct workqueue_struct *workq;
-	struct work_struct inv_work;
-	struct list_head inv_list;
+	struct delayed_work inv_dwork;
 	struct work_struct shrink_work;
-	struct list_head shrink_list;
 	atomic64_t next_refresh_gen;
+	atomic64_t last_ino_group;
+	atomic64_t recover_gen;
 
 	struct dentry *tseq_dentry;
 	struct scoutfs_tseq_tree tseq_tree;
+
+	struct lock_shard shards[LOCK_SHARD_NR];
 };
 
 #define DECLARE_LOCK_INFO(sb, name) \
 	struct lock_info *name = SCOUTFS_SB(sb)->lock_info
 
+#define for_each_lock_shard(linfo, shard)				\
+	for (shard = &(linfo)->shards[0];				\
+	     shard < &(linfo)->shards[LOCK_SHARD_NR]; shard++)
+
+/*
+ * The padding in keys isn't always initialized so we only hash the
+ * fields that are compared.
+ */
+static struct lock_shard *lock_shard(struct lock_info *linfo,
+				     struct scoutfs_key *start)
+{
+	u32 hash = scoutfs_hash32(start, offsetof(struct scoutfs_key, __pad));
+
+	return &linfo->shards[hash_32(hash, LOCK_SHARD_SHIFT)];
+}
+
 static bool lock_mode_invalid(enum scoutfs_lock_mode mode)
 {
 	return (unsigned)mode >= SCOUTFS_LOCK_INVALID;
@@ -148,6 +192,8 @@ static void invalidate_inode(struct super_block *sb, u64 ino)
 		if (S_ISREG(inode->i_mode)) {
 			truncate_inode_pages(inode->i_mapping, 0);
 			scoutfs_data_wait_changed(inode);
+		} else if (S_ISDIR(inode->i_mode)) {
+			scoutfs_dir_invalidate_index(inode);
 		}
 
 		forget_all_cached_acls(inode);
@@ -161,10 +207,18 @@ static void invalidate_inode(struct super_block *sb, u64 ino)
  * invalidating a write to a read or we're invalidating to null.  We
  * always have to write out dirty items if there are any.  We can only
  * leave cached items behind in the case of invalidating to a read lock.
+ *
+ * Read locks invalidated to null can also keep their items if the
+ * server gave us the lock's mod_seq.  The items can't be used until the
+ * lock is granted again and we then drop them if the server's mod_seq
+ * has changed.  Coverage and inodes are still invalidated.
  */
 static int lock_invalidate(struct super_block *sb, struct scoutfs_lock *lock,
-			   enum scoutfs_lock_mode prev, enum scoutfs_lock_mode mode)
+			   struct scoutfs_net_lock *nl)
 {
+	DECLARE_LOCK_INFO(sb, linfo);
+	enum scoutfs_lock_mode prev = nl->old_mode;
+	enum scoutfs_lock_mode mode = nl->new_mode;
 	struct scoutfs_lock_coverage *cov;
 	struct scoutfs_lock_coverage *tmp;
 	u64 ino, last;
@@ -213,17 +267,83 @@ retry:
 			}
 		}
 
-		scoutfs_item_invalidate(sb, &lock->start, &lock->end);
+		if (prev == SCOUTFS_LOCK_READ && mode == SCOUTFS_LOCK_NULL &&
+		    (nl->flags & SCOUTFS_NET_LOCK_FLAG_MOD_SEQ) && nl->write_seq != 0) {
+			spin_lock(&lock->shard->lock);
+			lock->retained_seq = le64_to_cpu(nl->write_seq);
+			lock->retained_gen = atomic64_read(&linfo->recover_gen);
+			spin_unlock(&lock->shard->lock);
+			scoutfs_inc_counter(sb, lock_retain);
+		} else {
+			scoutfs_item_invalidate(sb, &lock->start, &lock->end);
+		}
 	}
 
+	/* tell the server if a write lock didn't modify items */
+	nl->flags = 0;
+	if (lock_mode_can_write(prev) && !READ_ONCE(lock->items_dirtied))
+		nl->flags |= SCOUTFS_NET_LOCK_FLAG_UNMODIFIED;
+
 	return ret;
 }
 
+/*
+ * Keep or drop a lock's retained items.  The lock is busy with a
+ * pending request so it can't be used or freed while we drop the shard
+ * lock to count and invalidate the items.
+ */
+static void finish_retained_items(struct super_block *sb, struct scoutfs_lock *lock,
+				  bool keep)
+{
+	u64 nr;
+
+	assert_spin_locked(&lock->shard->lock);
+	BUG_ON(!lock->request_pending);
+
+	lock->retained_seq = 0;
+	spin_unlock(&lock->shard->lock);
+
+	nr = scoutfs_item_range_count(sb, &lock->start, &lock->end);
+	if (keep) {
+		scoutfs_add_counter(sb, lock_retain_items_kept, nr);
+	} else {
+		scoutfs_add_counter(sb, lock_retain_items_dropped, nr);
+		scoutfs_item_invalidate(sb, &lock->start, &lock->end);
+	}
+
+	spin_lock(&lock->shard->lock);
+}
+
+/*
+ * A lock that retained its items while it was null is being granted.
+ * The items can be used if the grant can read and the server's mod_seq
+ * for the lock hasn't changed since our read lock was invalidated.
+ * mod_seqs from previous servers can't be compared so recovery makes
+ * all retained items stale.  Returns true if the items were kept.
+ */
+static bool grant_retained_items(struct super_block *sb, struct scoutfs_lock *lock,
+				 struct scoutfs_net_lock *nl)
+{
+	DECLARE_LOCK_INFO(sb, linfo);
+	bool keep;
+
+	if (lock->retained_seq == 0)
+		return false;
+
+	keep = lock_mode_can_read(nl->new_mode) &&
+	       (nl->flags & SCOUTFS_NET_LOCK_FLAG_MOD_SEQ) &&
+	       le64_to_cpu(nl->write_seq) == lock->retained_seq &&
+	       lock->retained_gen == atomic64_read(&linfo->recover_gen);
+
+	finish_retained_items(sb, lock, keep);
+	return keep;
+}
+
 static void lock_free(struct lock_info *linfo, struct scoutfs_lock *lock)
 {
 	struct super_block *sb = lock->sb;
 
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&lock->shard->lock);
 
 	trace_scoutfs_lock_free(sb, lock);
 	scoutfs_inc_counter(sb, lock_free);
@@ -254,6 +374,7 @@ static struct scoutfs_lock *lock_alloc(struct super_block *sb,
 				       struct scoutfs_key *end)
 
 {
+	DECLARE_LOCK_INFO(sb, linfo);
 	struct scoutfs_lock *lock;
 
 	if (WARN_ON_ONCE(!start || !end))
@@ -277,6 +398,7 @@ static struct scoutfs_lock *lock_alloc(struct super_block *sb,
 	lock->start = *start;
 	lock->end = *end;
 	lock->sb = sb;
+	lock->shard = lock_shard(linfo, start);
 	init_waitqueue_head(&lock->waitq);
 	lock->mode = SCOUTFS_LOCK_NULL;
 	lock->invalidating_mode = SCOUTFS_LOCK_NULL;
@@ -344,6 +466,8 @@ static bool insert_range_node(struct super_block *sb, struct scoutfs_lock *ins)
 	struct scoutfs_lock *lock;
 	int cmp;
 
+	assert_spin_locked(&linfo->range_lock);
+
 	while (*node) {
 		parent = *node;
 		lock = container_of(*node, struct scoutfs_lock, range_node);
@@ -374,14 +498,16 @@ static bool insert_range_node(struct super_block *sb, struct scoutfs_lock *ins)
 static bool lock_insert(struct super_block *sb, struct scoutfs_lock *ins)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard = ins->shard;
 	struct scoutfs_lock *lock;
 	struct rb_node *parent;
 	struct rb_node **node;
+	bool inserted;
 	int cmp;
 
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&shard->lock);
 
-	node = &linfo->lock_tree.rb_node;
+	node = &shard->lock_tree.rb_node;
 	parent = NULL;
 	while (*node) {
 		parent = *node;
@@ -396,11 +522,14 @@ static bool lock_insert(struct super_block *sb, struct scoutfs_lock *ins)
 			return false;
 	}
 
-	if (!insert_range_node(sb, ins))
+	spin_lock(&linfo->range_lock);
+	inserted = insert_range_node(sb, ins);
+	spin_unlock(&linfo->range_lock);
+	if (!inserted)
 		return false;
 
 	rb_link_node(&ins->node, parent, node);
-	rb_insert_color(&ins->node, &linfo->lock_tree);
+	rb_insert_color(&ins->node, &shard->lock_tree);
 
 	scoutfs_tseq_add(&linfo->tseq_tree, &ins->tseq_entry);
 
@@ -409,26 +538,27 @@ static bool lock_insert(struct super_block *sb, struct scoutfs_lock *ins)
 
 static void lock_remove(struct lock_info *linfo, struct scoutfs_lock *lock)
 {
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&lock->shard->lock);
 
-	rb_erase(&lock->node, &linfo->lock_tree);
+	rb_erase(&lock->node, &lock->shard->lock_tree);
 	RB_CLEAR_NODE(&lock->node);
+	spin_lock(&linfo->range_lock);
 	rb_erase(&lock->range_node, &linfo->lock_range_tree);
 	RB_CLEAR_NODE(&lock->range_node);
+	spin_unlock(&linfo->range_lock);
 
 	scoutfs_tseq_del(&linfo->tseq_tree, &lock->tseq_entry);
 }
 
-static struct scoutfs_lock *lock_lookup(struct super_block *sb,
+static struct scoutfs_lock *lock_lookup(struct lock_shard *shard,
 					struct scoutfs_key *start,
 					struct scoutfs_lock **next)
 {
-	DECLARE_LOCK_INFO(sb, linfo);
-	struct rb_node *node = linfo->lock_tree.rb_node;
+	struct rb_node *node = shard->lock_tree.rb_node;
 	struct scoutfs_lock *lock;
 	int cmp;
 
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&shard->lock);
 
 	if (next)
 		*next = NULL;
@@ -451,13 +581,21 @@ static struct scoutfs_lock *lock_lookup(struct super_block *sb,
 	return NULL;
 }
 
+static struct scoutfs_lock *next_tree_lock(struct scoutfs_lock *lock)
+{
+	struct rb_node *node = rb_next(&lock->node);
+
+	return node ? rb_entry(node, struct scoutfs_lock, node) : NULL;
+}
+
 static void __lock_del_lru(struct lock_info *linfo, struct scoutfs_lock *lock)
 {
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&lock->shard->lock);
 
 	if (!list_empty(&lock->lru_head)) {
 		list_del_init(&lock->lru_head);
-		linfo->lru_nr--;
+		lock->shard->lru_nr--;
+		atomic_long_dec(&linfo->lru_nr);
 	}
 }
 
@@ -467,14 +605,15 @@ static void __lock_del_lru(struct lock_info *linfo, struct scoutfs_lock *lock)
  * Then later they call add_lru_or_free once they've cleared that state.
  */
 static struct scoutfs_lock *get_lock(struct super_block *sb,
+				     struct lock_shard *shard,
 				     struct scoutfs_key *start)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
 	struct scoutfs_lock *lock;
 
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&shard->lock);
 
-	lock = lock_lookup(sb, start, NULL);
+	lock = lock_lookup(shard, start, NULL);
 	if (lock)
 		__lock_del_lru(linfo, lock);
 
@@ -484,27 +623,29 @@ static struct scoutfs_lock *get_lock(struct super_block *sb,
 /*
  * Get a lock, creating it if it doesn't exist.  The caller must treat
  * the lock like it came from get lock (mark sate, drop lock, clear
- * state, put lock).  Allocated locks aren't on the lru.
+ * state, put lock).  Allocated locks aren't on the lru.  The caller
+ * holds the lock of the shard that the start key hashes to.
  */
 static struct scoutfs_lock *create_lock(struct super_block *sb,
+					struct lock_shard *shard,
 				 	struct scoutfs_key *start,
 					struct scoutfs_key *end)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
 	struct scoutfs_lock *lock;
 
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&shard->lock);
 
-	lock = get_lock(sb, start);
+	lock = get_lock(sb, shard, start);
 	if (!lock) {
-		spin_unlock(&linfo->lock);
+		spin_unlock(&shard->lock);
 		lock = lock_alloc(sb, start, end);
-		spin_lock(&linfo->lock);
+		spin_lock(&shard->lock);
 
 		if (lock) {
 			if (!lock_insert(sb, lock)) {
 				lock_free(linfo, lock);
-				lock = get_lock(sb, start);
+				lock = get_lock(sb, shard, start);
 			}
 		}
 	}
@@ -519,12 +660,15 @@ static struct scoutfs_lock *create_lock(struct super_block *sb,
  */
 static void put_lock(struct lock_info *linfo,struct scoutfs_lock *lock)
 {
-	assert_spin_locked(&linfo->lock);
+	struct lock_shard *shard = lock->shard;
+
+	assert_spin_locked(&shard->lock);
 
 	if (lock_idle(lock)) {
-		if (lock->mode != SCOUTFS_LOCK_NULL) {
-			list_add_tail(&lock->lru_head, &linfo->lru_list);
-			linfo->lru_nr++;
+		if (lock->mode != SCOUTFS_LOCK_NULL || lock->retained_seq) {
+			list_add_tail(&lock->lru_head, &shard->lru_list);
+			shard->lru_nr++;
+			atomic_long_inc(&linfo->lru_nr);
 		} else {
 			lock_remove(linfo, lock);
 			lock_free(linfo, lock);
@@ -536,12 +680,12 @@ static void put_lock(struct lock_info *linfo,struct scoutfs_lock *lock)
  * The caller has made a change (set a lock mode) which can let one of the
  * invalidating locks make forward progress.
  */
-static void queue_inv_work(struct lock_info *linfo)
+static void queue_inv_work(struct lock_info *linfo, struct lock_shard *shard)
 {
-	assert_spin_locked(&linfo->lock);
+	assert_spin_locked(&shard->lock);
 
-	if (!list_empty(&linfo->inv_list))
-		queue_work(linfo->workq, &linfo->inv_work);
+	if (!list_empty(&shard->inv_list))
+		mod_delayed_work(linfo->workq, &linfo->inv_dwork, 0);
 }
 
 /*
@@ -588,6 +732,63 @@ static void bug_on_inconsistent_grant_cache(struct super_block *sb,
 	}
 }
 
+/*
+ * Find the lock that has a pending request for the given key.  The
+ * caller holds the shard lock.
+ */
+static struct scoutfs_lock *lookup_pending_lock(struct super_block *sb,
+						struct lock_shard *shard,
+						struct scoutfs_key *key)
+{
+	struct scoutfs_lock *lock;
+
+	/* lock must already be busy with request_pending */
+	lock = lock_lookup(shard, key, NULL);
+	BUG_ON(!lock);
+	trace_scoutfs_lock_grant_response(sb, lock);
+	BUG_ON(!lock->request_pending);
+
+	return lock;
+}
+
+/*
+ * Give a lock the mode granted by the server, waking waiters and
+ * finishing with the request that made the lock busy.
+ */
+static void grant_lock(struct super_block *sb, struct scoutfs_lock *lock,
+		       struct scoutfs_net_lock *nl)
+{
+	DECLARE_LOCK_INFO(sb, linfo);
+	bool kept;
+
+	assert_spin_locked(&lock->shard->lock);
+
+	kept = grant_retained_items(sb, lock, nl);
+
+	/* kept items are as valid as if we'd held a read lock */
+	bug_on_inconsistent_grant_cache(sb, lock,
+					kept ? SCOUTFS_LOCK_READ : nl->old_mode,
+					nl->new_mode);
+
+	if (!lock_mode_can_read(nl->old_mode) && lock_mode_can_read(nl->new_mode))
+		lock->refresh_gen = atomic64_inc_return(&linfo->next_refresh_gen);
+
+	if (lock_mode_can_write(nl->new_mode) && !lock_mode_can_write(lock->mode))
+		WRITE_ONCE(lock->items_dirtied, false);
+
+	lock->request_pending = 0;
+	lock->mode = nl->new_mode;
+	lock->grant_jiffies = jiffies;
+	if (nl->flags & SCOUTFS_NET_LOCK_FLAG_MOD_SEQ)
+		lock->write_seq = 0;
+	else
+		lock->write_seq = le64_to_cpu(nl->write_seq);
+
+	trace_scoutfs_lock_granted(sb, lock);
+	wake_up(&lock->waitq);
+	put_lock(linfo, lock);
+}
+
 /*
  * The client is receiving a grant response message from the server.
  * This is being called synchronously in the networking receive path so
@@ -601,41 +802,139 @@ int scoutfs_lock_grant_response(struct super_block *sb,
 				struct scoutfs_net_lock *nl)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard = lock_shard(linfo, &nl->key);
 	struct scoutfs_lock *lock;
 
 	scoutfs_inc_counter(sb, lock_grant_response);
 
-	spin_lock(&linfo->lock);
+	spin_lock(&shard->lock);
 
-	/* lock must already be busy with request_pending */
-	lock = lock_lookup(sb, &nl->key, NULL);
-	BUG_ON(!lock);
-	trace_scoutfs_lock_grant_response(sb, lock);
-	BUG_ON(!lock->request_pending);
+	lock = lookup_pending_lock(sb, shard, &nl->key);
+	grant_lock(sb, lock, nl);
 
-	bug_on_inconsistent_grant_cache(sb, lock, nl->old_mode, nl->new_mode);
+	spin_unlock(&shard->lock);
 
-	if (!lock_mode_can_read(nl->old_mode) && lock_mode_can_read(nl->new_mode))
-		lock->refresh_gen = atomic64_inc_return(&linfo->next_refresh_gen);
+	return 0;
+}
 
-	lock->request_pending = 0;
-	lock->mode = nl->new_mode;
-	lock->write_seq = le64_to_cpu(nl->write_seq);
+/*
+ * The client is receiving the response to a batch of lock requests.
+ * Like single grant responses, this is called synchronously in the
+ * receive path.  Locks with an invalid mode weren't granted and are
+ * made idle again so that waiters send their own requests.  A null
+ * response means the batch failed and none of its locks were granted.
+ */
+int scoutfs_lock_batch_response(struct super_block *sb,
+				struct scoutfs_net_lock_batch *nlb,
+				struct scoutfs_net_lock_batch *rsp)
+{
+	DECLARE_LOCK_INFO(sb, linfo);
+	struct scoutfs_net_lock *nl;
+	struct lock_shard *shard;
+	struct scoutfs_lock *lock;
+	int i;
 
-	trace_scoutfs_lock_granted(sb, lock);
-	wake_up(&lock->waitq);
-	put_lock(linfo, lock);
+	for (i = 0; i < le16_to_cpu(nlb->nr); i++) {
+		nl = &nlb->locks[i];
+		shard = lock_shard(linfo, &nl->key);
+
+		spin_lock(&shard->lock);
+
+		lock = lookup_pending_lock(sb, shard, &nl->key);
+		if (rsp && rsp->locks[i].new_mode != SCOUTFS_LOCK_INVALID) {
+			scoutfs_inc_counter(sb, lock_batch_granted);
+			grant_lock(sb, lock, &rsp->locks[i]);
+		} else {
+			scoutfs_inc_counter(sb, lock_batch_denied);
+			lock->request_pending = 0;
+			wake_up(&lock->waitq);
+			put_lock(linfo, lock);
+		}
 
-	spin_unlock(&linfo->lock);
+		spin_unlock(&shard->lock);
+	}
 
 	return 0;
 }
 
+/*
+ * Send one request for the mode on all the given lock ranges which
+ * don't already have a matching mode or a request or invalidation in
+ * flight.  The ranges must be sorted by their start keys.  We don't
+ * wait for the response.  Callers that need the locks wait in the
+ * usual lock path which sends a single request if the batch wasn't
+ * granted, or wasn't sent because the server doesn't support batches.
+ */
+static void lock_batch_request(struct super_block *sb, enum scoutfs_lock_mode mode,
+			       struct scoutfs_key *starts, struct scoutfs_key *ends,
+			       int nr)
+{
+	DECLARE_LOCK_INFO(sb, linfo);
+	struct scoutfs_net_lock_batch *nlb;
+	struct scoutfs_net_lock *nl;
+	struct lock_shard *shard;
+	struct scoutfs_lock *lock;
+	int ret;
+	int n;
+	int i;
+
+	if (WARN_ON_ONCE(nr > SCOUTFS_NET_LOCK_BATCH_MAX_NR) || linfo->shutdown ||
+	    !scoutfs_client_lock_batch_supported(sb))
+		return;
+
+	nlb = kmalloc(offsetof(struct scoutfs_net_lock_batch, locks[nr]), GFP_NOFS);
+	if (!nlb)
+		return;
+
+	for (i = 0, n = 0; i < nr; i++) {
+		shard = lock_shard(linfo, &starts[i]);
+		spin_lock(&shard->lock);
+
+		/* drops and re-acquires lock if it allocates */
+		lock = create_lock(sb, shard, &starts[i], &ends[i]);
+		if (lock) {
+			if (lock_modes_match(lock->mode, mode) ||
+			    lock->request_pending || lock->invalidate_pending) {
+				put_lock(linfo, lock);
+			} else {
+				lock->request_pending = 1;
+				nl = &nlb->locks[n++];
+				nl->key = lock->start;
+				nl->write_seq = 0;
+				nl->old_mode = lock->mode;
+				nl->new_mode = mode;
+				nl->flags = 0;
+				memset(nl->__pad, 0, sizeof(nl->__pad));
+			}
+		}
+
+		spin_unlock(&shard->lock);
+	}
+
+	if (n == 0) {
+		kfree(nlb);
+		return;
+	}
+
+	nlb->nr = cpu_to_le16(n);
+	memset(nlb->__pad, 0, sizeof(nlb->__pad));
+
+	/* the response frees the batch */
+	ret = scoutfs_client_lock_batch_request(sb, nlb);
+	if (ret < 0) {
+		scoutfs_lock_batch_response(sb, nlb, NULL);
+		kfree(nlb);
+	} else {
+		scoutfs_inc_counter(sb, lock_batch_request);
+	}
+}
+
 struct inv_req {
 	struct list_head head;
 	struct scoutfs_lock *lock;
 	u64 net_id;
 	struct scoutfs_net_lock nl;
+	bool held;
 };
 
 /*
@@ -660,26 +959,47 @@ struct inv_req {
  * using the lock while we're invalidating.  We record the previously
  * granted mode so that we can send lock recover responses with the old
  * granted mode during invalidation.
+ *
+ * The worker walks the shards and invalidates each shard's ready locks
+ * without holding the shard lock.
+ *
+ * Write locks can be held for a minimum time after they're granted
+ * before we invalidate them.  Mounts that are contending for a write
+ * lock, typically creating in a shared directory, then get to perform
+ * a burst of operations per grant instead of paying for a lock round
+ * trip and transaction commit for each operation.  We return the
+ * number of jiffies until the first held lock can be invalidated.
  */
-static void lock_invalidate_worker(struct work_struct *work)
+static void invalidate_shard(struct lock_info *linfo, struct lock_shard *shard,
+			     unsigned long hold, unsigned long *delay)
 {
-	struct lock_info *linfo = container_of(work, struct lock_info, inv_work);
 	struct super_block *sb = linfo->sb;
 	struct scoutfs_net_lock *nl;
 	struct scoutfs_lock *lock;
 	struct scoutfs_lock *tmp;
+	unsigned long now = jiffies;
 	struct inv_req *ireq;
 	LIST_HEAD(ready);
 	int ret;
 
-	scoutfs_inc_counter(sb, lock_invalidate_work);
-
-	spin_lock(&linfo->lock);
+	spin_lock(&shard->lock);
 
-	list_for_each_entry_safe(lock, tmp, &linfo->inv_list, inv_head) {
+	list_for_each_entry_safe(lock, tmp, &shard->inv_list, inv_head) {
 		ireq = list_first_entry(&lock->inv_list, struct inv_req, head);
 		nl = &ireq->nl;
 
+		/* let recently granted writers keep working */
+		if (hold && lock->mode == SCOUTFS_LOCK_WRITE &&
+		    time_before(now, lock->grant_jiffies + hold)) {
+			*delay = min(*delay, lock->grant_jiffies + hold - now);
+			/* count each request once, not each worker pass */
+			if (!ireq->held) {
+				ireq->held = true;
+				scoutfs_inc_counter(sb, lock_invalidate_held);
+			}
+			continue;
+		}
+
 		/* wait until incompatible holders unlock */
 		if (!lock_counts_match(nl->new_mode, lock->users))
 			continue;
@@ -692,7 +1012,7 @@ static void lock_invalidate_worker(struct work_struct *work)
 		list_move_tail(&lock->inv_head, &ready);
 	}
 
-	spin_unlock(&linfo->lock);
+	spin_unlock(&shard->lock);
 
 	if (list_empty(&ready))
 		return;
@@ -704,7 +1024,7 @@ static void lock_invalidate_worker(struct work_struct *work)
 
 		/* only lock protocol, inv can't call subsystems after shutdown */
 		if (!linfo->shutdown) {
-			ret = lock_invalidate(sb, lock, nl->old_mode, nl->new_mode);
+			ret = lock_invalidate(sb, lock, nl);
 			BUG_ON(ret);
 		}
 
@@ -718,7 +1038,7 @@ static void lock_invalidate_worker(struct work_struct *work)
 	}
 
 	/* and finish all the invalidated locks */
-	spin_lock(&linfo->lock);
+	spin_lock(&shard->lock);
 
 	list_for_each_entry_safe(lock, tmp, &ready, inv_head) {
 		ireq = list_first_entry(&lock->inv_list, struct inv_req, head);
@@ -737,14 +1057,37 @@ static void lock_invalidate_worker(struct work_struct *work)
 			wake_up(&lock->waitq);
 		} else {
 			/* another request arrived, back on the list and requeue */
-			list_move_tail(&lock->inv_head, &linfo->inv_list);
-			queue_inv_work(linfo);
+			list_move_tail(&lock->inv_head, &shard->inv_list);
+			queue_inv_work(linfo, shard);
 		}
 
 		put_lock(linfo, lock);
 	}
 
-	spin_unlock(&linfo->lock);
+	spin_unlock(&shard->lock);
+}
+
+static void lock_invalidate_worker(struct work_struct *work)
+{
+	struct lock_info *linfo = container_of(work, struct lock_info, inv_dwork.work);
+	struct scoutfs_mount_options opts;
+	unsigned long delay = ULONG_MAX;
+	unsigned long hold = 0;
+	struct lock_shard *shard;
+
+	scoutfs_inc_counter(linfo->sb, lock_invalidate_work);
+
+	/* don't hold locks once unmount needs invalidation to finish */
+	if (!linfo->shutdown && !linfo->unmounting) {
+		scoutfs_options_read(linfo->sb, &opts);
+		hold = msecs_to_jiffies(opts.lock_min_hold_ms);
+	}
+
+	for_each_lock_shard(linfo, shard)
+		invalidate_shard(linfo, shard, hold, &delay);
+
+	if (delay != ULONG_MAX)
+		queue_delayed_work(linfo->workq, &linfo->inv_dwork, delay);
 }
 
 /*
@@ -770,6 +1113,7 @@ int scoutfs_lock_invalidate_request(struct super_block *sb, u64 net_id,
 				    struct scoutfs_net_lock *nl)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard = lock_shard(linfo, &nl->key);
 	struct scoutfs_lock *lock = NULL;
 	struct inv_req *ireq;
 	int ret = 0;
@@ -783,21 +1127,22 @@ int scoutfs_lock_invalidate_request(struct super_block *sb, u64 net_id,
 		goto out;
 	}
 
-	spin_lock(&linfo->lock);
-	lock = get_lock(sb, &nl->key);
+	spin_lock(&shard->lock);
+	lock = get_lock(sb, shard, &nl->key);
 	if (lock) {
 		trace_scoutfs_lock_invalidate_request(sb, lock);
 		ireq->lock = lock;
 		ireq->net_id = net_id;
 		ireq->nl = *nl;
+		ireq->held = false;
 		if (list_empty(&lock->inv_list)) {
-			list_add_tail(&lock->inv_head, &linfo->inv_list);
+			list_add_tail(&lock->inv_head, &shard->inv_list);
 			lock->invalidate_pending = 1;
-			queue_inv_work(linfo);
+			queue_inv_work(linfo, shard);
 		}
 		list_add_tail(&ireq->head, &lock->inv_list);
 	}
-	spin_unlock(&linfo->lock);
+	spin_unlock(&shard->lock);
 
 out:
 	if (!lock) {
@@ -814,54 +1159,74 @@ out:
  * that we've sent all our locks.  This is called in client processing
  * so the client won't try to reconnect to another server until we
  * return.
+ *
+ * Locks are sorted within each shard so we find the next lock in key
+ * order by finding the smallest next lock in all the shards.  This
+ * only happens during recovery so we don't mind the repeated searching.
  */
 int scoutfs_lock_recover_request(struct super_block *sb, u64 net_id,
 				 struct scoutfs_key *key)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
 	struct scoutfs_net_lock_recover *nlr;
+	struct scoutfs_net_lock *found;
 	enum scoutfs_lock_mode mode;
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct scoutfs_lock *next;
-	struct rb_node *node;
+	struct scoutfs_key pos;
 	int ret;
 	int i;
 
 	scoutfs_inc_counter(sb, lock_recover_request);
 
+	/* a new server can't compare our retained items' mod_seqs */
+	atomic64_inc(&linfo->recover_gen);
+
 	nlr = kmalloc(offsetof(struct scoutfs_net_lock_recover,
 			       locks[SCOUTFS_NET_LOCK_MAX_RECOVER_NR]),
 		      GFP_NOFS);
 	if (!nlr)
 		return -ENOMEM;
 
-	spin_lock(&linfo->lock);
-
-	lock = lock_lookup(sb, key, &next) ?: next;
-
-	for (i = 0; lock && i < SCOUTFS_NET_LOCK_MAX_RECOVER_NR; i++) {
+	pos = *key;
+
+	for (i = 0; i < SCOUTFS_NET_LOCK_MAX_RECOVER_NR; i++) {
+		found = NULL;
+
+		for_each_lock_shard(linfo, shard) {
+			spin_lock(&shard->lock);
+
+			lock = lock_lookup(shard, &pos, &next) ?: next;
+			/* the server doesn't know about idle retained null locks */
+			while (lock && lock_idle(lock) && lock->mode == SCOUTFS_LOCK_NULL)
+				lock = next_tree_lock(lock);
+			if (lock && (!found ||
+				     scoutfs_key_compare(&lock->start, &found->key) < 0)) {
+				if (lock->invalidating_mode != SCOUTFS_LOCK_NULL)
+					mode = lock->invalidating_mode;
+				else
+					mode = lock->mode;
+
+				found = &nlr->locks[i];
+				found->key = lock->start;
+				found->write_seq = cpu_to_le64(lock->write_seq);
+				found->old_mode = mode;
+				found->new_mode = mode;
+			}
 
-		if (lock->invalidating_mode != SCOUTFS_LOCK_NULL)
-			mode = lock->invalidating_mode;
-		else
-			mode = lock->mode;
+			spin_unlock(&shard->lock);
+		}
 
-		nlr->locks[i].key = lock->start;
-		nlr->locks[i].write_seq = cpu_to_le64(lock->write_seq);
-		nlr->locks[i].old_mode = mode;
-		nlr->locks[i].new_mode = mode;
+		if (!found)
+			break;
 
-		node = rb_next(&lock->node);
-		if (node)
-			lock = rb_entry(node, struct scoutfs_lock, node);
-		else
-			lock = NULL;
+		pos = found->key;
+		scoutfs_key_inc(&pos);
 	}
 
 	nlr->nr = cpu_to_le16(i);
 
-	spin_unlock(&linfo->lock);
-
 	ret = scoutfs_client_lock_recover_response(sb, net_id, nlr);
 	kfree(nlr);
 	return ret;
@@ -873,10 +1238,10 @@ static bool lock_wait_cond(struct super_block *sb, struct scoutfs_lock *lock,
 	DECLARE_LOCK_INFO(sb, linfo);
 	bool wake;
 
-	spin_lock(&linfo->lock);
+	spin_lock(&lock->shard->lock);
 	wake = linfo->shutdown || lock_modes_match(lock->mode, mode) ||
 	       !lock->request_pending;
-	spin_unlock(&linfo->lock);
+	spin_unlock(&lock->shard->lock);
 
 	if (!wake)
 		scoutfs_inc_counter(sb, lock_wait);
@@ -907,6 +1272,7 @@ static int lock_key_range(struct super_block *sb, enum scoutfs_lock_mode mode, i
 			  struct scoutfs_lock **ret_lock)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct scoutfs_net_lock nl;
 	bool should_send;
@@ -929,10 +1295,11 @@ static int lock_key_range(struct super_block *sb, enum scoutfs_lock_mode mode, i
 	if (WARN_ON_ONCE(scoutfs_trans_held()))
 		return -EDEADLK;
 
-	spin_lock(&linfo->lock);
+	shard = lock_shard(linfo, start);
+	spin_lock(&shard->lock);
 
 	/* drops and re-acquires lock if it allocates */
-	lock = create_lock(sb, start, end);
+	lock = create_lock(sb, shard, start, end);
 	if (!lock) {
 		ret = -ENOMEM;
 		goto out_unlock;
@@ -969,16 +1336,17 @@ static int lock_key_range(struct super_block *sb, enum scoutfs_lock_mode mode, i
 			should_send = false;
 		}
 
-		spin_unlock(&linfo->lock);
+		spin_unlock(&shard->lock);
 
 		if (should_send) {
+			memset(&nl, 0, sizeof(nl));
 			nl.key = lock->start;
 			nl.old_mode = lock->mode;
 			nl.new_mode = mode;
 
 			ret = scoutfs_client_lock_request(sb, &nl);
 			if (ret) {
-				spin_lock(&linfo->lock);
+				spin_lock(&shard->lock);
 				lock->request_pending = 0;
 				break;
 			}
@@ -995,7 +1363,7 @@ static int lock_key_range(struct super_block *sb, enum scoutfs_lock_mode mode, i
 			ret = 0;
 		}
 
-		spin_lock(&linfo->lock);
+		spin_lock(&shard->lock);
 		if (ret)
 			break;
 	}
@@ -1008,7 +1376,7 @@ static int lock_key_range(struct super_block *sb, enum scoutfs_lock_mode mode, i
 	put_lock(linfo, lock);
 
 out_unlock:
-	spin_unlock(&linfo->lock);
+	spin_unlock(&shard->lock);
 
 	if (ret && ret != -EAGAIN && ret != -ERESTARTSYS)
 		scoutfs_inc_counter(sb, lock_lock_error);
@@ -1016,21 +1384,72 @@ out_unlock:
 	return ret;
 }
 
+static void ino_lock_range(u64 ino, struct scoutfs_key *start, struct scoutfs_key *end)
+{
+	scoutfs_key_set_zeros(start);
+	start->sk_zone = SCOUTFS_FS_ZONE;
+	start->ski_ino = cpu_to_le64(ino & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK);
+
+	scoutfs_key_set_ones(end);
+	end->sk_zone = SCOUTFS_FS_ZONE;
+	end->ski_ino = cpu_to_le64(ino | SCOUTFS_LOCK_INODE_GROUP_MASK);
+}
+
+#define LOCK_PREFETCH_GROUPS	4
+
+/*
+ * When read locks are acquired on consecutive inode groups we send a
+ * batch request for read locks on the next few groups.  The server
+ * only grants batched locks that don't conflict so prefetching can't
+ * steal locks from other mounts.  Groups that are already locked or
+ * have requests in flight are skipped so advancing by a group only
+ * requests the newly exposed group.
+ */
+static void prefetch_ino_locks(struct super_block *sb, u64 ino)
+{
+	DECLARE_LOCK_INFO(sb, linfo);
+	struct scoutfs_key starts[LOCK_PREFETCH_GROUPS];
+	struct scoutfs_key ends[LOCK_PREFETCH_GROUPS];
+	struct scoutfs_mount_options opts;
+	u64 group = ino / SCOUTFS_LOCK_INODE_GROUP_NR;
+	u64 prev;
+	int nr;
+
+	scoutfs_options_read(sb, &opts);
+	if (!opts.lock_prefetch)
+		return;
+
+	prev = atomic64_xchg(&linfo->last_ino_group, group);
+	if (prev + 1 != group)
+		return;
+
+	for (nr = 0; nr < LOCK_PREFETCH_GROUPS; nr++) {
+		ino = (group + 1 + nr) * SCOUTFS_LOCK_INODE_GROUP_NR;
+		if (ino < SCOUTFS_LOCK_INODE_GROUP_NR)
+			break;
+		ino_lock_range(ino, &starts[nr], &ends[nr]);
+	}
+
+	if (nr > 0) {
+		scoutfs_inc_counter(sb, lock_prefetch);
+		lock_batch_request(sb, SCOUTFS_LOCK_READ, starts, ends, nr);
+	}
+}
+
 int scoutfs_lock_ino(struct super_block *sb, enum scoutfs_lock_mode mode, int flags, u64 ino,
 		     struct scoutfs_lock **ret_lock)
 {
 	struct scoutfs_key start;
 	struct scoutfs_key end;
+	int ret;
 
-	scoutfs_key_set_zeros(&start);
-	start.sk_zone = SCOUTFS_FS_ZONE;
-	start.ski_ino = cpu_to_le64(ino & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK);
+	ino_lock_range(ino, &start, &end);
 
-	scoutfs_key_set_ones(&end);
-	end.sk_zone = SCOUTFS_FS_ZONE;
-	end.ski_ino = cpu_to_le64(ino | SCOUTFS_LOCK_INODE_GROUP_MASK);
+	ret = lock_key_range(sb, mode, flags, &start, &end, ret_lock);
+	if (ret == 0 && mode == SCOUTFS_LOCK_READ && !(flags & SCOUTFS_LKF_NONBLOCK))
+		prefetch_ino_locks(sb, ino);
 
-	return lock_key_range(sb, mode, flags, &start, &end, ret_lock);
+	return ret;
 }
 
 /*
@@ -1113,7 +1532,10 @@ int scoutfs_lock_inodes(struct super_block *sb, enum scoutfs_lock_mode mode, int
 	struct lock_inodes_arg args[] = {
 		{a, a_lock}, {b, b_lock}, {c, c_lock}, {d, D_lock},
 	};
+	struct scoutfs_key starts[ARRAY_SIZE(args)];
+	struct scoutfs_key ends[ARRAY_SIZE(args)];
 	int ret;
+	int nr;
 	int i;
 
 	/* set all lock pointers to null and validating input */
@@ -1130,6 +1552,17 @@ int scoutfs_lock_inodes(struct super_block *sb, enum scoutfs_lock_mode mode, int
 	/* sort by having an inode then inode number */
 	sort(args, ARRAY_SIZE(args), sizeof(args[0]), cmp_arg, swap_arg);
 
+	/* request multiple missing groups in one message */
+	if (!(flags & SCOUTFS_LKF_NONBLOCK)) {
+		for (i = 0, nr = 0; i < ARRAY_SIZE(args) && args[i].inode; i++) {
+			ino_lock_range(scoutfs_ino(args[i].inode), &starts[nr], &ends[nr]);
+			if (nr == 0 || scoutfs_key_compare(&starts[nr - 1], &starts[nr]) != 0)
+				nr++;
+		}
+		if (nr > 1)
+			lock_batch_request(sb, mode, starts, ends, nr);
+	}
+
 	/* lock unique inodes */
 	for (i = 0; i < ARRAY_SIZE(args) && args[i].inode; i++) {
 		ret = scoutfs_lock_inode(sb, mode, flags, args[i].inode,
@@ -1261,7 +1694,7 @@ void scoutfs_unlock(struct super_block *sb, struct scoutfs_lock *lock, enum scou
 
 	scoutfs_inc_counter(sb, lock_unlock);
 
-	spin_lock(&linfo->lock);
+	spin_lock(&lock->shard->lock);
 
 	lock_dec_count(lock->users, mode);
 	if (lock_mode_can_write(mode))
@@ -1269,10 +1702,10 @@ void scoutfs_unlock(struct super_block *sb, struct scoutfs_lock *lock, enum scou
 
 	trace_scoutfs_lock_unlock(sb, lock);
 	wake_up(&lock->waitq);
-	queue_inv_work(linfo);
+	queue_inv_work(linfo, lock->shard);
 	put_lock(linfo, lock);
 
-	spin_unlock(&linfo->lock);
+	spin_unlock(&lock->shard->lock);
 }
 
 void scoutfs_lock_init_coverage(struct scoutfs_lock_coverage *cov)
@@ -1366,6 +1799,7 @@ static void lock_shrink_worker(struct work_struct *work)
 					       shrink_work);
 	struct super_block *sb = linfo->sb;
 	struct scoutfs_net_lock nl;
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct scoutfs_lock *tmp;
 	LIST_HEAD(list);
@@ -1373,14 +1807,29 @@ static void lock_shrink_worker(struct work_struct *work)
 
 	scoutfs_inc_counter(sb, lock_shrink_work);
 
-	spin_lock(&linfo->lock);
-	list_splice_init(&linfo->shrink_list, &list);
-	spin_unlock(&linfo->lock);
+	for_each_lock_shard(linfo, shard) {
+		spin_lock(&shard->lock);
+		list_splice_tail_init(&shard->shrink_list, &list);
+		spin_unlock(&shard->lock);
+	}
 
 	list_for_each_entry_safe(lock, tmp, &list, shrink_head) {
 		list_del_init(&lock->shrink_head);
 
+		/* null locks retaining items are only known locally */
+		if (lock->mode == SCOUTFS_LOCK_NULL) {
+			spin_lock(&lock->shard->lock);
+			if (lock->retained_seq)
+				finish_retained_items(sb, lock, false);
+			lock->request_pending = 0;
+			wake_up(&lock->waitq);
+			put_lock(linfo, lock);
+			spin_unlock(&lock->shard->lock);
+			continue;
+		}
+
 		/* unlocked lock access, but should be stable since we queued */
+		memset(&nl, 0, sizeof(nl));
 		nl.key = lock->start;
 		nl.old_mode = lock->mode;
 		nl.new_mode = SCOUTFS_LOCK_NULL;
@@ -1390,13 +1839,13 @@ static void lock_shrink_worker(struct work_struct *work)
 			/* oh well, not freeing */
 			scoutfs_inc_counter(sb, lock_shrink_aborted);
 
-			spin_lock(&linfo->lock);
+			spin_lock(&lock->shard->lock);
 
 			lock->request_pending = 0;
 			wake_up(&lock->waitq);
 			put_lock(linfo, lock);
 
-			spin_unlock(&linfo->lock);
+			spin_unlock(&lock->shard->lock);
 		}
 	}
 }
@@ -1409,7 +1858,7 @@ static unsigned long lock_count_objects(struct shrinker *shrink,
 
 	scoutfs_inc_counter(sb, lock_count_objects);
 
-	return shrinker_min_long(linfo->lru_nr);
+	return shrinker_min_long(atomic_long_read(&linfo->lru_nr));
 }
 
 /*
@@ -1423,47 +1872,61 @@ static unsigned long lock_count_objects(struct shrinker *shrink,
  * from being freed.  It'll block waiting to send its request for its
  * mode which will prevent the lock from being freed when the null
  * response arrives.
+ *
+ * Each shard has its own lru.  We start scanning from the shard after
+ * the one that the previous scan stopped in so that pressure is spread
+ * over all the shards.
  */
 static unsigned long lock_scan_objects(struct shrinker *shrink,
 				       struct shrink_control *sc)
 {
 	struct lock_info *linfo = KC_SHRINKER_CONTAINER_OF(shrink, struct lock_info);
 	struct super_block *sb = linfo->sb;
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct scoutfs_lock *tmp;
 	unsigned long freed = 0;
 	unsigned long nr = sc->nr_to_scan;
+	unsigned int first;
+	unsigned int i;
 	bool added = false;
 
 	scoutfs_inc_counter(sb, lock_scan_objects);
 
-	spin_lock(&linfo->lock);
+	first = READ_ONCE(linfo->next_shrink_shard);
+
+	for (i = 0; i < LOCK_SHARD_NR && nr > 0; i++) {
+		shard = &linfo->shards[(first + i) % LOCK_SHARD_NR];
 
+		spin_lock(&shard->lock);
 restart:
-	list_for_each_entry_safe(lock, tmp, &linfo->lru_list, lru_head) {
+		list_for_each_entry_safe(lock, tmp, &shard->lru_list, lru_head) {
 
-		BUG_ON(!lock_idle(lock));
-		BUG_ON(lock->mode == SCOUTFS_LOCK_NULL);
-		BUG_ON(!list_empty(&lock->shrink_head));
+			BUG_ON(!lock_idle(lock));
+			BUG_ON(lock->mode == SCOUTFS_LOCK_NULL && !lock->retained_seq);
+			BUG_ON(!list_empty(&lock->shrink_head));
 
-		if (nr-- == 0)
-			break;
+			if (nr == 0)
+				break;
+			nr--;
 
-		__lock_del_lru(linfo, lock);
-		lock->request_pending = 1;
-		list_add_tail(&lock->shrink_head, &linfo->shrink_list);
-		added = true;
-		freed++;
+			__lock_del_lru(linfo, lock);
+			lock->request_pending = 1;
+			list_add_tail(&lock->shrink_head, &shard->shrink_list);
+			added = true;
+			freed++;
 
-		scoutfs_inc_counter(sb, lock_shrink_attempted);
-		trace_scoutfs_lock_shrink(sb, lock);
+			scoutfs_inc_counter(sb, lock_shrink_attempted);
+			trace_scoutfs_lock_shrink(sb, lock);
 
-		/* could have bazillions of idle locks */
-		if (cond_resched_lock(&linfo->lock))
-			goto restart;
+			/* could have bazillions of idle locks */
+			if (cond_resched_lock(&shard->lock))
+				goto restart;
+		}
+		spin_unlock(&shard->lock);
 	}
 
-	spin_unlock(&linfo->lock);
+	WRITE_ONCE(linfo->next_shrink_shard, (first + i) % LOCK_SHARD_NR);
 
 	if (added)
 		queue_work(linfo->workq, &linfo->shrink_work);
@@ -1510,7 +1973,7 @@ void scoutfs_lock_unmount_begin(struct super_block *sb)
 
 	if (linfo) {
 		linfo->unmounting = true;
-		flush_work(&linfo->inv_work);
+		flush_delayed_work(&linfo->inv_dwork);
 	}
 }
 
@@ -1519,12 +1982,13 @@ void scoutfs_lock_flush_invalidate(struct super_block *sb)
 	DECLARE_LOCK_INFO(sb, linfo);
 
 	if (linfo)
-		flush_work(&linfo->inv_work);
+		flush_delayed_work(&linfo->inv_dwork);
 }
 
 static u64 get_held_lock_refresh_gen(struct super_block *sb, struct scoutfs_key *start)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	u64 refresh_gen = 0;
 
@@ -1532,13 +1996,14 @@ static u64 get_held_lock_refresh_gen(struct super_block *sb, struct scoutfs_key
 	if (!linfo)
 		return 0;
 
-	spin_lock(&linfo->lock);
-	lock = lock_lookup(sb, start, NULL);
+	shard = lock_shard(linfo, start);
+	spin_lock(&shard->lock);
+	lock = lock_lookup(shard, start, NULL);
 	if (lock) {
 		if (lock_mode_can_read(lock->mode))
 			refresh_gen = lock->refresh_gen;
 	}
-	spin_unlock(&linfo->lock);
+	spin_unlock(&shard->lock);
 
 	return refresh_gen;
 }
@@ -1578,6 +2043,7 @@ u64 scoutfs_lock_ino_refresh_gen(struct super_block *sb, u64 ino)
 void scoutfs_lock_shutdown(struct super_block *sb)
 {
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct rb_node *node;
 
@@ -1591,13 +2057,15 @@ void scoutfs_lock_shutdown(struct super_block *sb)
 	flush_work(&linfo->shrink_work);
 
 	/* cause current and future lock calls to return errors */
-	spin_lock(&linfo->lock);
 	linfo->shutdown = true;
-	for (node = rb_first(&linfo->lock_tree); node; node = rb_next(node)) {
-		lock = rb_entry(node, struct scoutfs_lock, node);
-		wake_up(&lock->waitq);
+	for_each_lock_shard(linfo, shard) {
+		spin_lock(&shard->lock);
+		for (node = rb_first(&shard->lock_tree); node; node = rb_next(node)) {
+			lock = rb_entry(node, struct scoutfs_lock, node);
+			wake_up(&lock->waitq);
+		}
+		spin_unlock(&shard->lock);
 	}
-	spin_unlock(&linfo->lock);
 }
 
 /*
@@ -1616,6 +2084,7 @@ void scoutfs_lock_destroy(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
 	DECLARE_LOCK_INFO(sb, linfo);
+	struct lock_shard *shard;
 	struct scoutfs_lock *lock;
 	struct inv_req *ireq_tmp;
 	struct inv_req *ireq;
@@ -1629,20 +2098,22 @@ void scoutfs_lock_destroy(struct super_block *sb)
 
 
 	/* make sure that no one's actively using locks */
-	spin_lock(&linfo->lock);
-	for (node = rb_first(&linfo->lock_tree); node; node = rb_next(node)) {
-		lock = rb_entry(node, struct scoutfs_lock, node);
-
-		for (mode = 0; mode < SCOUTFS_LOCK_NR_MODES; mode++) {
-			if (lock->waiters[mode] || lock->users[mode]) {
-				scoutfs_warn(sb, "lock start "SK_FMT" end "SK_FMT" has mode %d user after shutdown",
-						SK_ARG(&lock->start),
-						SK_ARG(&lock->end), mode);
-				break;
+	for_each_lock_shard(linfo, shard) {
+		spin_lock(&shard->lock);
+		for (node = rb_first(&shard->lock_tree); node; node = rb_next(node)) {
+			lock = rb_entry(node, struct scoutfs_lock, node);
+
+			for (mode = 0; mode < SCOUTFS_LOCK_NR_MODES; mode++) {
+				if (lock->waiters[mode] || lock->users[mode]) {
+					scoutfs_warn(sb, "lock start "SK_FMT" end "SK_FMT" has mode %d user after shutdown",
+							SK_ARG(&lock->start),
+							SK_ARG(&lock->end), mode);
+					break;
+				}
 			}
 		}
+		spin_unlock(&shard->lock);
 	}
-	spin_unlock(&linfo->lock);
 
 	if (linfo->workq) {
 		/* now all work won't queue itself */
@@ -1660,33 +2131,35 @@ void scoutfs_lock_destroy(struct super_block *sb)
 	 * being called (and would trip assertions in our manual calling
 	 * of free).
 	 */
-	spin_lock(&linfo->lock);
+	for_each_lock_shard(linfo, shard) {
+		spin_lock(&shard->lock);
 
-	node = rb_first(&linfo->lock_tree);
-	while (node) {
-		lock = rb_entry(node, struct scoutfs_lock, node);
-		node = rb_next(node);
+		node = rb_first(&shard->lock_tree);
+		while (node) {
+			lock = rb_entry(node, struct scoutfs_lock, node);
+			node = rb_next(node);
 
-		list_for_each_entry_safe(ireq, ireq_tmp, &lock->inv_list, head) {
-			list_del_init(&ireq->head);
-			put_lock(linfo, ireq->lock);
-			kfree(ireq);
-		}
+			list_for_each_entry_safe(ireq, ireq_tmp, &lock->inv_list, head) {
+				list_del_init(&ireq->head);
+				put_lock(linfo, ireq->lock);
+				kfree(ireq);
+			}
 
-		lock->request_pending = 0;
-		if (!list_empty(&lock->lru_head))
-			__lock_del_lru(linfo, lock);
-		if (!list_empty(&lock->inv_head)) {
-			list_del_init(&lock->inv_head);
-			lock->invalidate_pending = 0;
+			lock->request_pending = 0;
+			if (!list_empty(&lock->lru_head))
+				__lock_del_lru(linfo, lock);
+			if (!list_empty(&lock->inv_head)) {
+				list_del_init(&lock->inv_head);
+				lock->invalidate_pending = 0;
+			}
+			if (!list_empty(&lock->shrink_head))
+				list_del_init(&lock->shrink_head);
+			lock_remove(linfo, lock);
+			lock_free(linfo, lock);
 		}
-		if (!list_empty(&lock->shrink_head))
-			list_del_init(&lock->shrink_head);
-		lock_remove(linfo, lock);
-		lock_free(linfo, lock);
-	}
 
-	spin_unlock(&linfo->lock);
+		spin_unlock(&shard->lock);
+	}
 
 	kfree(linfo);
 	sbi->lock_info = NULL;
@@ -1695,6 +2168,7 @@ void scoutfs_lock_destroy(struct super_block *sb)
 int scoutfs_lock_setup(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
+	struct lock_shard *shard;
 	struct lock_info *linfo;
 	int ret;
 
@@ -1703,18 +2177,24 @@ int scoutfs_lock_setup(struct super_block *sb)
 		return -ENOMEM;
 
 	linfo->sb = sb;
-	spin_lock_init(&linfo->lock);
-	linfo->lock_tree = RB_ROOT;
+	for_each_lock_shard(linfo, shard) {
+		spin_lock_init(&shard->lock);
+		shard->lock_tree = RB_ROOT;
+		INIT_LIST_HEAD(&shard->lru_list);
+		INIT_LIST_HEAD(&shard->inv_list);
+		INIT_LIST_HEAD(&shard->shrink_list);
+	}
+	spin_lock_init(&linfo->range_lock);
 	linfo->lock_range_tree = RB_ROOT;
+	atomic_long_set(&linfo->lru_nr, 0);
+	INIT_DELAYED_WORK(&linfo->inv_dwork, lock_invalidate_worker);
+	INIT_WORK(&linfo->shrink_work, lock_shrink_worker);
 	KC_INIT_SHRINKER_FUNCS(&linfo->shrinker, lock_count_objects,
 			       lock_scan_objects);
 	KC_REGISTER_SHRINKER(&linfo->shrinker);
-	INIT_LIST_HEAD(&linfo->lru_list);
-	INIT_WORK(&linfo->inv_work, lock_invalidate_worker);
-	INIT_LIST_HEAD(&linfo->inv_list);
-	INIT_WORK(&linfo->shrink_work, lock_shrink_worker);
-	INIT_LIST_HEAD(&linfo->shrink_list);
 	atomic64_set(&linfo->next_refresh_gen, 0);
+	atomic64_set(&linfo->last_ino_group, 0);
+	atomic64_set(&linfo->recover_gen, 0);
 	scoutfs_tseq_tree_init(&linfo->tseq_tree, lock_tseq_show);
 
 	sbi->lock_info = linfo;
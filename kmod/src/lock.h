@@ -12,6 +12,7 @@
 #define SCOUTFS_LOCK_NR_MODES		SCOUTFS_LOCK_INVALID
 
 struct inode_deletion_lock_data;
+struct lock_shard;
 
 /*
  * A few fields (start, end, refresh_gen, write_seq, granted_mode)
@@ -19,6 +20,7 @@ struct inode_deletion_lock_data;
  */
 struct scoutfs_lock {
 	struct super_block *sb;
+	struct lock_shard *shard;
 	struct scoutfs_key start;
 	struct scoutfs_key end;
 	struct rb_node node;
@@ -26,6 +28,10 @@ struct scoutfs_lock {
 	u64 refresh_gen;
 	u64 write_seq;
 	u64 dirty_trans_seq;
+	u64 retained_seq;
+	u64 retained_gen;
+	bool items_dirtied;
+	unsigned long grant_jiffies;
 	struct list_head lru_head;
 	wait_queue_head_t waitq;
 	unsigned long request_pending:1,
@@ -60,6 +66,9 @@ struct scoutfs_lock_coverage {
 
 int scoutfs_lock_grant_response(struct super_block *sb,
 				struct scoutfs_net_lock *nl);
+int scoutfs_lock_batch_response(struct super_block *sb,
+				struct scoutfs_net_lock_batch *nlb,
+				struct scoutfs_net_lock_batch *rsp);
 int scoutfs_lock_invalidate_request(struct super_block *sb, u64 net_id,
 				    struct scoutfs_net_lock *nl);
 int scoutfs_lock_recover_request(struct super_block *sb, u64 net_id,
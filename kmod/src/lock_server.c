@@ -13,6 +13,7 @@
 #include <linux/kernel.h>
 #include <linux/fs.h>
 #include <linux/slab.h>
+#include <linux/hash.h>
 
 #include "format.h"
 #include "counters.h"
@@ -24,6 +25,7 @@
 #include "scoutfs_trace.h"
 #include "lock_server.h"
 #include "recov.h"
+#include "hash.h"
 
 /*
  * The scoutfs server implements a simple lock service.  Client mounts
@@ -39,7 +41,9 @@
  * We separate the locking of the global index of tracked locks from the
  * locking of a lock's state.  This allows concurrent work on unrelated
  * locks and lets processing block sending responses to unresponsive
- * clients without affecting other locks.
+ * clients without affecting other locks.  The index is itself split
+ * into shards by the hash of the lock keys so that concurrent request
+ * processing for different locks rarely contends on the index locks.
  *
  * Correctness of the protocol relies on the client and server each only
  * sending one request at a time for a given lock.  The server won't
@@ -70,11 +74,18 @@
 
 #define LOCK_SERVER_RECOVERY_MS	(10 * MSEC_PER_SEC)
 
-struct lock_server_info {
-	struct super_block *sb;
+#define LOCK_SERVER_SHARD_SHIFT	6
+#define LOCK_SERVER_SHARD_NR	(1 << LOCK_SERVER_SHARD_SHIFT)
 
+struct server_lock_shard {
 	spinlock_t lock;
 	struct rb_root locks_root;
+} ____cacheline_aligned_in_smp;
+
+struct lock_server_info {
+	struct super_block *sb;
+
+	struct server_lock_shard shards[LOCK_SERVER_SHARD_NR];
 
 	struct scoutfs_tseq_tree tseq_tree;
 	struct dentry *tseq_dentry;
@@ -85,6 +96,19 @@ struct lock_server_info {
 #define DECLARE_LOCK_SERVER_INFO(sb, name) \
 	struct lock_server_info *name = SCOUTFS_SB(sb)->lock_server_info
 
+#define for_each_server_lock_shard(inf, shard)				\
+	for (shard = &(inf)->shards[0];					\
+	     shard < &(inf)->shards[LOCK_SERVER_SHARD_NR]; shard++)
+
+/* the key padding isn't always initialized, only hash compared fields */
+static struct server_lock_shard *server_lock_shard(struct lock_server_info *inf,
+						   struct scoutfs_key *key)
+{
+	u32 hash = scoutfs_hash32(key, offsetof(struct scoutfs_key, __pad));
+
+	return &inf->shards[hash_32(hash, LOCK_SERVER_SHARD_SHIFT)];
+}
+
 /*
  * The state of a lock on the server is a function of the state of the
  * locks on all clients.
@@ -96,19 +120,30 @@ struct lock_server_info {
  *
  * While the invalidated list has entries, which means invalidation
  * messages are still in flight, no more requests will be processed.
+ *
+ * @mod_seq:
+ * A seq that changes whenever a client could have modified items
+ * covered by the lock.  It's sent to readers as their read locks are
+ * invalidated and granted so that they can keep their cached items
+ * across invalidation if nothing was modified in the meantime.
  */
 struct server_lock_node {
 	atomic_t refcount;
 	struct mutex mutex;
 	struct rb_node node;
 	struct scoutfs_key key;
+	struct server_lock_shard *shard;
 
 	struct list_head granted;
 	struct list_head requested;
 	struct list_head invalidated;
+	u64 mod_seq;
 
 	struct scoutfs_tseq_entry stats_tseq_entry;
 	u64 stats[SLT_NR];
+	u64 remote_invalidations;
+	unsigned long created;
+	atomic64_t contended;
 };
 
 /*
@@ -184,6 +219,35 @@ static bool invalid_mode(u8 mode)
 	return mode >= SCOUTFS_LOCK_INVALID;
 }
 
+static bool mode_can_write(u8 mode)
+{
+	return mode == SCOUTFS_LOCK_WRITE || mode == SCOUTFS_LOCK_WRITE_ONLY;
+}
+
+/*
+ * A client's grant that could have modified items is going away.  We
+ * don't know which items it modified so readers have to drop all their
+ * cached items covered by the lock.  Seqs are unique across servers
+ * for the life of a server, clients drop retained items when they
+ * recover with a new server.
+ */
+static void modified_server_lock(struct super_block *sb,
+				 struct server_lock_node *snode)
+{
+	snode->mod_seq = scoutfs_server_next_seq(sb);
+}
+
+/*
+ * Read grants and invalidations of read locks to null carry the lock's
+ * mod_seq so that the client can keep its cached items.  Everything
+ * else just has its write_seq.
+ */
+static void set_mod_seq(struct scoutfs_net_lock *nl, struct server_lock_node *snode)
+{
+	nl->write_seq = cpu_to_le64(snode->mod_seq);
+	nl->flags = SCOUTFS_NET_LOCK_FLAG_MOD_SEQ;
+}
+
 /*
  * Return the mode that we should invalidate a granted lock down to
  * given an incompatible requested mode.  Usually we completely
@@ -223,13 +287,20 @@ static bool client_entries_compatible(struct client_lock_entry *granted,
  * Get a locked server lock, possibly inserting the caller's allocated
  * lock if we don't find one for the given key.  The server lock's mutex
  * is held on return and the caller must put the lock when they're done.
+ * Batch requests hold multiple locks in key order and give each its own
+ * lockdep subclass.
+ *
+ * or_next only returns the next lock in the shard that the key hashes
+ * to.  Callers that iterate over all the locks walk each shard with
+ * get_next_server_lock().
  */
-static struct server_lock_node *get_server_lock(struct lock_server_info *inf,
-						struct scoutfs_key *key,
-						struct server_lock_node *ins,
-						bool or_next)
+static struct server_lock_node *get_shard_server_lock(struct lock_server_info *inf,
+						      struct server_lock_shard *shard,
+						      struct scoutfs_key *key,
+						      struct server_lock_node *ins,
+						      bool or_next, unsigned int subclass)
 {
-	struct rb_root *root = &inf->locks_root;
+	struct rb_root *root = &shard->locks_root;
 	struct server_lock_node *ret = NULL;
 	struct server_lock_node *next = NULL;
 	struct server_lock_node *snode;
@@ -237,7 +308,10 @@ static struct server_lock_node *get_server_lock(struct lock_server_info *inf,
 	struct rb_node **node;
 	int cmp;
 
-	spin_lock(&inf->lock);
+	if (!spin_trylock(&shard->lock)) {
+		scoutfs_inc_counter(inf->sb, lock_server_shard_contended);
+		spin_lock(&shard->lock);
+	}
 
 	node = &root->rb_node;
 	while (*node) {
@@ -269,33 +343,61 @@ static struct server_lock_node *get_server_lock(struct lock_server_info *inf,
 	if (ret)
 		atomic_inc(&ret->refcount);
 
-	spin_unlock(&inf->lock);
+	spin_unlock(&shard->lock);
 
-	if (ret)
-		mutex_lock(&ret->mutex);
+	if (ret && !mutex_trylock(&ret->mutex)) {
+		atomic64_inc(&ret->contended);
+		scoutfs_inc_counter(inf->sb, lock_server_mutex_contended);
+		mutex_lock_nested(&ret->mutex, subclass);
+	}
 
 	return ret;
 }
 
+static struct server_lock_node *get_server_lock(struct lock_server_info *inf,
+						struct scoutfs_key *key,
+						struct server_lock_node *ins,
+						unsigned int subclass)
+{
+	return get_shard_server_lock(inf, server_lock_shard(inf, key), key, ins, false,
+				     subclass);
+}
+
+/*
+ * Return the next server lock at or after the key in the given shard.
+ * The caller advances the key past the returned lock to iterate.
+ */
+static struct server_lock_node *get_next_server_lock(struct lock_server_info *inf,
+						     struct server_lock_shard *shard,
+						     struct scoutfs_key *key)
+{
+	return get_shard_server_lock(inf, shard, key, NULL, true, 0);
+}
+
 /* Get a server lock node, allocating if one doesn't exist.  Caller must put. */
 static struct server_lock_node *alloc_server_lock(struct lock_server_info *inf,
-						  struct scoutfs_key *key)
+						  struct scoutfs_key *key,
+						  unsigned int subclass)
 {
 	struct server_lock_node *snode;
 	struct server_lock_node *ins;
 
-	snode = get_server_lock(inf, key, NULL, false);
+	snode = get_server_lock(inf, key, NULL, subclass);
 	if (snode == NULL) {
 		ins = kzalloc(sizeof(struct server_lock_node), GFP_NOFS);
 		if (ins) {
 			atomic_set(&ins->refcount, 0);
 			mutex_init(&ins->mutex);
 			ins->key = *key;
+			ins->shard = server_lock_shard(inf, key);
 			INIT_LIST_HEAD(&ins->granted);
 			INIT_LIST_HEAD(&ins->requested);
 			INIT_LIST_HEAD(&ins->invalidated);
+			ins->mod_seq = scoutfs_server_next_seq(inf->sb);
+			ins->created = jiffies;
+			atomic64_set(&ins->contended, 0);
 
-			snode = get_server_lock(inf, key, ins, false);
+			snode = get_server_lock(inf, key, ins, subclass);
 			if (snode != ins)
 				kfree(ins);
 			else
@@ -313,6 +415,7 @@ static struct server_lock_node *alloc_server_lock(struct lock_server_info *inf,
 static void put_server_lock(struct lock_server_info *inf,
 			    struct server_lock_node *snode)
 {
+	struct server_lock_shard *shard = snode->shard;
 	bool should_free = false;
 
 	BUG_ON(!mutex_is_locked(&snode->mutex));
@@ -321,9 +424,9 @@ static void put_server_lock(struct lock_server_info *inf,
 	    list_empty(&snode->granted) &&
 	    list_empty(&snode->requested) &&
 	    list_empty(&snode->invalidated)) {
-		spin_lock(&inf->lock);
-		rb_erase(&snode->node, &inf->locks_root);
-		spin_unlock(&inf->lock);
+		spin_lock(&shard->lock);
+		rb_erase(&snode->node, &shard->locks_root);
+		spin_unlock(&shard->lock);
 		should_free = true;
 	}
 
@@ -387,7 +490,7 @@ int scoutfs_lock_server_request(struct super_block *sb, u64 rid,
 	c_ent->net_id = net_id;
 	c_ent->mode = nl->new_mode;
 
-	snode = alloc_server_lock(inf, &nl->key);
+	snode = alloc_server_lock(inf, &nl->key, 0);
 	if (snode == NULL) {
 		kfree(c_ent);
 		ret = -ENOMEM;
@@ -405,6 +508,163 @@ out:
 	return ret;
 }
 
+static bool invalid_batch(struct scoutfs_net_lock_batch *nlb)
+{
+	struct scoutfs_net_lock *nl;
+	int nr = le16_to_cpu(nlb->nr);
+	int i;
+
+	if (nr == 0 || nr > SCOUTFS_NET_LOCK_BATCH_MAX_NR)
+		return true;
+
+	for (i = 0; i < nr; i++) {
+		nl = &nlb->locks[i];
+		if (invalid_mode(nl->old_mode) || invalid_mode(nl->new_mode) ||
+		    nl->new_mode == SCOUTFS_LOCK_NULL ||
+		    (i > 0 && scoutfs_key_compare(&nlb->locks[i - 1].key, &nl->key) >= 0))
+			return true;
+	}
+
+	return false;
+}
+
+/*
+ * The server is receiving a batch of lock requests from a client.
+ * Unlike single requests, batched requests are never queued.  Each
+ * lock is granted immediately if it doesn't have to wait for recovery
+ * or other requests and is compatible with all the current grants.
+ * Locks that can't be granted are returned with an invalid mode and the
+ * client falls back to single requests which wait for invalidation.
+ * Batches are opportunistic and never cost other clients their locks.
+ *
+ * We hold all the server locks in key order until the response is sent
+ * so that invalidations of the granted locks can't be sent before the
+ * grants.
+ */
+int scoutfs_lock_server_request_batch(struct super_block *sb, u64 rid,
+				      u64 net_id, struct scoutfs_net_lock_batch *nlb)
+{
+	DECLARE_LOCK_SERVER_INFO(sb, inf);
+	struct server_lock_node *snodes[SCOUTFS_NET_LOCK_BATCH_MAX_NR] = {NULL, };
+	struct client_lock_entry *c_ents[SCOUTFS_NET_LOCK_BATCH_MAX_NR] = {NULL, };
+	struct scoutfs_net_lock_batch *rsp = NULL;
+	struct client_lock_entry *c_ent;
+	struct client_lock_entry *other;
+	struct client_lock_entry *gr;
+	struct scoutfs_net_lock *nl;
+	bool recovering;
+	bool grant;
+	u64 seq;
+	int ret;
+	int nr;
+	int i;
+
+	BUILD_BUG_ON(SCOUTFS_NET_LOCK_BATCH_MAX_NR > MAX_LOCKDEP_SUBCLASSES);
+
+	if (invalid_batch(nlb)) {
+		ret = -EINVAL;
+		goto out;
+	}
+
+	nr = le16_to_cpu(nlb->nr);
+
+	rsp = kmemdup(nlb, offsetof(struct scoutfs_net_lock_batch, locks[nr]),
+		      GFP_NOFS);
+	if (!rsp) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	for (i = 0; i < nr; i++) {
+		c_ents[i] = kzalloc(sizeof(struct client_lock_entry), GFP_NOFS);
+		if (!c_ents[i]) {
+			ret = -ENOMEM;
+			goto out;
+		}
+		INIT_LIST_HEAD(&c_ents[i]->head);
+	}
+
+	for (i = 0; i < nr; i++) {
+		snodes[i] = alloc_server_lock(inf, &nlb->locks[i].key, i);
+		if (!snodes[i]) {
+			ret = -ENOMEM;
+			goto out;
+		}
+	}
+
+	recovering = scoutfs_recov_next_pending(sb, 0, SCOUTFS_RECOV_LOCKS) != 0;
+
+	for (i = 0; i < nr; i++) {
+		nl = &rsp->locks[i];
+		c_ent = c_ents[i];
+
+		trace_scoutfs_lock_message(sb, SLT_SERVER, SLT_GRANT, SLT_REQUEST,
+					   rid, net_id, nl);
+		snodes[i]->stats[SLT_REQUEST]++;
+
+		c_ent->rid = rid;
+		c_ent->net_id = net_id;
+		c_ent->mode = nl->new_mode;
+
+		gr = find_entry(snodes[i], &snodes[i]->granted, rid);
+		grant = !recovering &&
+			list_empty(&snodes[i]->invalidated) &&
+			list_empty(&snodes[i]->requested) &&
+			(gr ? gr->mode : SCOUTFS_LOCK_NULL) == nl->old_mode;
+
+		list_for_each_entry(other, &snodes[i]->granted, head) {
+			if (!grant)
+				break;
+			grant = client_entries_compatible(other, c_ent);
+		}
+
+		if (!grant) {
+			nl->new_mode = SCOUTFS_LOCK_INVALID;
+			nl->write_seq = 0;
+			nl->flags = 0;
+			scoutfs_inc_counter(sb, lock_server_batch_denied);
+			continue;
+		}
+
+		if (gr) {
+			if (mode_can_write(gr->mode))
+				modified_server_lock(sb, snodes[i]);
+			free_client_entry(inf, snodes[i], gr);
+		}
+
+		nl->write_seq = 0;
+		nl->flags = 0;
+		if (mode_can_write(nl->new_mode)) {
+			/* doesn't commit seq update, recovered with locks */
+			seq = scoutfs_server_next_seq(sb);
+			nl->write_seq = cpu_to_le64(seq);
+		} else if (nl->new_mode == SCOUTFS_LOCK_READ) {
+			set_mod_seq(nl, snodes[i]);
+		}
+
+		c_ents[i] = NULL;
+		c_ent->snode = snodes[i];
+		add_client_entry(snodes[i], &snodes[i]->granted, c_ent);
+		scoutfs_tseq_add(&inf->tseq_tree, &c_ent->tseq_entry);
+
+		trace_scoutfs_lock_message(sb, SLT_SERVER, SLT_GRANT,
+					   SLT_RESPONSE, rid, net_id, nl);
+		snodes[i]->stats[SLT_GRANT]++;
+		scoutfs_inc_counter(sb, lock_server_batch_granted);
+	}
+
+	ret = scoutfs_server_lock_batch_response(sb, rid, net_id, rsp);
+out:
+	for (i = SCOUTFS_NET_LOCK_BATCH_MAX_NR - 1; i >= 0; i--) {
+		if (snodes[i])
+			put_server_lock(inf, snodes[i]);
+		kfree(c_ents[i]);
+	}
+	kfree(rsp);
+
+	return ret;
+}
+
 /*
  * The server is receiving an invalidation response from the client.
  * Find the client's entry on the server lock's invalidation list and
@@ -430,7 +690,7 @@ int scoutfs_lock_server_response(struct super_block *sb, u64 rid,
 	}
 
 	/* XXX should always have a server lock here? */
-	snode = get_server_lock(inf, &nl->key, NULL, false);
+	snode = get_server_lock(inf, &nl->key, NULL, 0);
 	if (!snode) {
 		ret = -EINVAL;
 		goto out;
@@ -445,6 +705,11 @@ int scoutfs_lock_server_response(struct super_block *sb, u64 rid,
 		goto out;
 	}
 
+	/* clients tell us if they didn't modify items under a write grant */
+	if (mode_can_write(c_ent->mode) &&
+	    !(nl->flags & SCOUTFS_NET_LOCK_FLAG_UNMODIFIED))
+		modified_server_lock(sb, snode);
+
 	if (nl->new_mode == SCOUTFS_LOCK_NULL) {
 		free_client_entry(inf, snode, c_ent);
 	} else {
@@ -510,6 +775,12 @@ static int process_waiting_requests(struct super_block *sb,
 			nl.key = snode->key;
 			nl.old_mode = gr->mode;
 			nl.new_mode = invalidation_mode(gr->mode, req->mode);
+			nl.write_seq = 0;
+			nl.flags = 0;
+			memset(nl.__pad, 0, sizeof(nl.__pad));
+			if (nl.old_mode == SCOUTFS_LOCK_READ &&
+			    nl.new_mode == SCOUTFS_LOCK_NULL)
+				set_mod_seq(&nl, snode);
 
 			ret = scoutfs_server_lock_request(sb, gr->rid, &nl);
 			if (ret)
@@ -519,6 +790,8 @@ static int process_waiting_requests(struct super_block *sb,
 						   SLT_INVALIDATE, SLT_REQUEST,
 						   gr->rid, 0, &nl);
 			snode->stats[SLT_INVALIDATE]++;
+			if (gr->rid != req->rid)
+				snode->remote_invalidations++;
 
 			add_client_entry(snode, &snode->invalidated, gr);
 		}
@@ -530,21 +803,26 @@ static int process_waiting_requests(struct super_block *sb,
 		nl.key = snode->key;
 		nl.new_mode = req->mode;
 		nl.write_seq = 0;
+		nl.flags = 0;
+		memset(nl.__pad, 0, sizeof(nl.__pad));
 
 		/* see if there's an existing compatible grant to replace */
 		gr = find_entry(snode, &snode->granted, req->rid);
 		if (gr) {
 			nl.old_mode = gr->mode;
+			if (mode_can_write(gr->mode))
+				modified_server_lock(sb, snode);
 			free_client_entry(inf, snode, gr);
 		} else {
 			nl.old_mode = SCOUTFS_LOCK_NULL;
 		}
 
-		if (nl.new_mode == SCOUTFS_LOCK_WRITE ||
-		    nl.new_mode == SCOUTFS_LOCK_WRITE_ONLY) {
+		if (mode_can_write(nl.new_mode)) {
 			/* doesn't commit seq update, recovered with locks */
 			seq = scoutfs_server_next_seq(sb);
 			nl.write_seq = cpu_to_le64(seq);
+		} else if (nl.new_mode == SCOUTFS_LOCK_READ) {
+			set_mod_seq(&nl, snode);
 		}
 
 		ret = scoutfs_server_lock_response(sb, req->rid,
@@ -599,25 +877,29 @@ int scoutfs_lock_server_greeting(struct super_block *sb, u64 rid)
 int scoutfs_lock_server_finished_recovery(struct super_block *sb)
 {
 	DECLARE_LOCK_SERVER_INFO(sb, inf);
+	struct server_lock_shard *shard;
 	struct server_lock_node *snode;
 	struct scoutfs_key key;
 	int ret = 0;
 
-	scoutfs_key_set_zeros(&key);
-	while ((snode = get_server_lock(inf, &key, NULL, true))) {
+	for_each_server_lock_shard(inf, shard) {
+		scoutfs_key_set_zeros(&key);
+		while ((snode = get_next_server_lock(inf, shard, &key))) {
 
-		key = snode->key;
-		scoutfs_key_inc(&key);
+			key = snode->key;
+			scoutfs_key_inc(&key);
 
-		if (!list_empty(&snode->requested)) {
-			ret = process_waiting_requests(sb, snode);
-			if (ret)
-				break;
-		} else {
-			put_server_lock(inf, snode);
+			if (!list_empty(&snode->requested)) {
+				ret = process_waiting_requests(sb, snode);
+				if (ret)
+					goto out;
+			} else {
+				put_server_lock(inf, snode);
+			}
 		}
 	}
 
+out:
 	return ret;
 }
 
@@ -663,7 +945,7 @@ int scoutfs_lock_server_recover_response(struct super_block *sb, u64 rid,
 		c_ent->net_id = 0;
 		c_ent->mode = nlr->locks[i].new_mode;
 
-		snode = alloc_server_lock(inf, &nlr->locks[i].key);
+		snode = alloc_server_lock(inf, &nlr->locks[i].key, 0);
 		if (snode == NULL) {
 			kfree(c_ent);
 			ret = -ENOMEM;
@@ -709,38 +991,43 @@ int scoutfs_lock_server_farewell(struct super_block *sb, u64 rid)
 	DECLARE_LOCK_SERVER_INFO(sb, inf);
 	struct client_lock_entry *c_ent;
 	struct client_lock_entry *tmp;
+	struct server_lock_shard *shard;
 	struct server_lock_node *snode;
 	struct scoutfs_key key;
 	struct list_head *list;
 	bool freed;
 	int ret = 0;
 
-	scoutfs_key_set_zeros(&key);
-	while ((snode = get_server_lock(inf, &key, NULL, true))) {
-
-		freed = false;
-		for (list = &snode->granted; list != NULL;
-		     list = (list == &snode->granted) ? &snode->requested :
-			    (list == &snode->requested) ? &snode->invalidated :
-			    NULL) {
-
-			list_for_each_entry_safe(c_ent, tmp, list, head) {
-				if (c_ent->rid == rid) {
-					free_client_entry(inf, snode, c_ent);
-					freed = true;
+	for_each_server_lock_shard(inf, shard) {
+		scoutfs_key_set_zeros(&key);
+		while ((snode = get_next_server_lock(inf, shard, &key))) {
+
+			freed = false;
+			for (list = &snode->granted; list != NULL;
+			     list = (list == &snode->granted) ? &snode->requested :
+				    (list == &snode->requested) ? &snode->invalidated :
+				    NULL) {
+
+				list_for_each_entry_safe(c_ent, tmp, list, head) {
+					if (c_ent->rid == rid) {
+						if (mode_can_write(c_ent->mode))
+							modified_server_lock(sb, snode);
+						free_client_entry(inf, snode, c_ent);
+						freed = true;
+					}
 				}
 			}
-		}
 
-		key = snode->key;
-		scoutfs_key_inc(&key);
+			key = snode->key;
+			scoutfs_key_inc(&key);
 
-		if (freed) {
-			ret = process_waiting_requests(sb, snode);
-			if (ret)
-				goto out;
-		} else {
-			put_server_lock(inf, snode);
+			if (freed) {
+				ret = process_waiting_requests(sb, snode);
+				if (ret)
+					goto out;
+			} else {
+				put_server_lock(inf, snode);
+			}
 		}
 	}
 	ret = 0;
@@ -798,14 +1085,25 @@ static void lock_server_tseq_show(struct seq_file *m,
 		   c_ent->net_id);
 }
 
+/*
+ * The request rate is averaged over the life of the server lock which
+ * ends once all clients have dropped it.  Contention counts the number
+ * of times that processing had to wait for another to finish with the
+ * lock.  Remote invalidations are sent to a client other than the one
+ * whose request caused them and show locks bouncing between mounts.
+ */
 static void stats_tseq_show(struct seq_file *m, struct scoutfs_tseq_entry *ent)
 {
 	struct server_lock_node *snode = container_of(ent, struct server_lock_node,
 						      stats_tseq_entry);
+	u64 ms = max_t(u64, jiffies_to_msecs(jiffies - snode->created), 1);
 
-	seq_printf(m, SK_FMT" req %llu inv %llu rsp %llu gr %llu\n",
+	seq_printf(m, SK_FMT" req %llu inv %llu rsp %llu gr %llu rinv %llu cont %llu req_per_sec %llu\n",
 		   SK_ARG(&snode->key), snode->stats[SLT_REQUEST], snode->stats[SLT_INVALIDATE],
-		   snode->stats[SLT_RESPONSE], snode->stats[SLT_GRANT]);
+		   snode->stats[SLT_RESPONSE], snode->stats[SLT_GRANT],
+		   snode->remote_invalidations,
+		   (u64)atomic64_read(&snode->contended),
+		   div64_u64(snode->stats[SLT_REQUEST] * MSEC_PER_SEC, ms));
 }
 
 /*
@@ -815,6 +1113,7 @@ static void stats_tseq_show(struct seq_file *m, struct scoutfs_tseq_entry *ent)
 int scoutfs_lock_server_setup(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
+	struct server_lock_shard *shard;
 	struct lock_server_info *inf;
 
 	inf = kzalloc(sizeof(struct lock_server_info), GFP_KERNEL);
@@ -822,8 +1121,10 @@ int scoutfs_lock_server_setup(struct super_block *sb)
 		return -ENOMEM;
 
 	inf->sb = sb;
-	spin_lock_init(&inf->lock);
-	inf->locks_root = RB_ROOT;
+	for_each_server_lock_shard(inf, shard) {
+		spin_lock_init(&shard->lock);
+		shard->locks_root = RB_ROOT;
+	}
 	scoutfs_tseq_tree_init(&inf->tseq_tree, lock_server_tseq_show);
 	scoutfs_tseq_tree_init(&inf->stats_tseq_tree, stats_tseq_show);
 
@@ -855,6 +1156,7 @@ void scoutfs_lock_server_destroy(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
 	DECLARE_LOCK_SERVER_INFO(sb, inf);
+	struct server_lock_shard *shard;
 	struct server_lock_node *snode;
 	struct server_lock_node *stmp;
 	struct client_lock_entry *c_ent;
@@ -865,20 +1167,22 @@ void scoutfs_lock_server_destroy(struct super_block *sb)
 		debugfs_remove(inf->tseq_dentry);
 		debugfs_remove(inf->stats_tseq_dentry);
 
-		rbtree_postorder_for_each_entry_safe(snode, stmp,
-						     &inf->locks_root, node) {
+		for_each_server_lock_shard(inf, shard) {
+			rbtree_postorder_for_each_entry_safe(snode, stmp,
+							     &shard->locks_root, node) {
 
-			list_splice_init(&snode->granted, &list);
-			list_splice_init(&snode->requested, &list);
-			list_splice_init(&snode->invalidated, &list);
+				list_splice_init(&snode->granted, &list);
+				list_splice_init(&snode->requested, &list);
+				list_splice_init(&snode->invalidated, &list);
 
-			mutex_lock(&snode->mutex);
-			list_for_each_entry_safe(c_ent, ctmp, &list, head) {
-				free_client_entry(inf, snode, c_ent);
-			}
-			mutex_unlock(&snode->mutex);
+				mutex_lock(&snode->mutex);
+				list_for_each_entry_safe(c_ent, ctmp, &list, head) {
+					free_client_entry(inf, snode, c_ent);
+				}
+				mutex_unlock(&snode->mutex);
 
-			kfree(snode);
+				kfree(snode);
+			}
 		}
 
 		kfree(inf);
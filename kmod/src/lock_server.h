@@ -6,6 +6,8 @@ int scoutfs_lock_server_recover_response(struct super_block *sb, u64 rid,
 int scoutfs_lock_server_finished_recovery(struct super_block *sb);
 int scoutfs_lock_server_request(struct super_block *sb, u64 rid,
 				u64 net_id, struct scoutfs_net_lock *nl);
+int scoutfs_lock_server_request_batch(struct super_block *sb, u64 rid,
+				      u64 net_id, struct scoutfs_net_lock_batch *nlb);
 int scoutfs_lock_server_greeting(struct super_block *sb, u64 rid);
 int scoutfs_lock_server_response(struct super_block *sb, u64 rid,
 				 struct scoutfs_net_lock *nl);
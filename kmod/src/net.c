@@ -20,6 +20,7 @@
 #include <net/sock.h>
 #include <net/tcp.h>
 #include <linux/log2.h>
+#include <linux/percpu.h>
 
 #include "format.h"
 #include "counters.h"
@@ -31,6 +32,7 @@
 #include "endian_swap.h"
 #include "tseq.h"
 #include "fence.h"
+#include "sysfs.h"
 
 /*
  * scoutfs networking delivers requests and responses between nodes.
@@ -76,15 +78,105 @@
  * A connection's shutdown work executes in its own workqueue so that the
  * work can free the connection's workq.
  */
+/*
+ * Messages received by the server are processed in workqueues shared
+ * by all the accepted connections, chosen by the priority class of the
+ * message's command.  Lock traffic has its own high priority workqueue
+ * so that it never waits for workers that are blocked in expensive
+ * requests holding commits.  The expensive bulk requests are limited in
+ * how many can be processed at once.  Clients process all their
+ * messages in their connection's workqueue.
+ */
+enum net_proc_class {
+	NET_PROC_LOCK = 0,
+	NET_PROC_NORMAL,
+	NET_PROC_BULK,
+	NET_PROC_NR,
+	NET_PROC_CONN = NET_PROC_NR,
+};
+
+#define NET_PROC_BULK_MAX_ACTIVE	64
+
+static char *net_proc_class_names[] = {
+	[NET_PROC_LOCK] = "lock",
+	[NET_PROC_NORMAL] = "normal",
+	[NET_PROC_BULK] = "bulk",
+};
+
+static char *net_cmd_names[] = {
+	[SCOUTFS_NET_CMD_GREETING] = "greeting",
+	[SCOUTFS_NET_CMD_ALLOC_INODES] = "alloc_inodes",
+	[SCOUTFS_NET_CMD_GET_LOG_TREES] = "get_log_trees",
+	[SCOUTFS_NET_CMD_COMMIT_LOG_TREES] = "commit_log_trees",
+	[SCOUTFS_NET_CMD_SYNC_LOG_TREES] = "sync_log_trees",
+	[SCOUTFS_NET_CMD_GET_ROOTS] = "get_roots",
+	[SCOUTFS_NET_CMD_GET_LAST_SEQ] = "get_last_seq",
+	[SCOUTFS_NET_CMD_LOCK] = "lock",
+	[SCOUTFS_NET_CMD_LOCK_RECOVER] = "lock_recover",
+	[SCOUTFS_NET_CMD_SRCH_GET_COMPACT] = "srch_get_compact",
+	[SCOUTFS_NET_CMD_SRCH_COMMIT_COMPACT] = "srch_commit_compact",
+	[SCOUTFS_NET_CMD_GET_LOG_MERGE] = "get_log_merge",
+	[SCOUTFS_NET_CMD_COMMIT_LOG_MERGE] = "commit_log_merge",
+	[SCOUTFS_NET_CMD_OPEN_INO_MAP] = "open_ino_map",
+	[SCOUTFS_NET_CMD_GET_VOLOPT] = "get_volopt",
+	[SCOUTFS_NET_CMD_SET_VOLOPT] = "set_volopt",
+	[SCOUTFS_NET_CMD_CLEAR_VOLOPT] = "clear_volopt",
+	[SCOUTFS_NET_CMD_RESIZE_DEVICES] = "resize_devices",
+	[SCOUTFS_NET_CMD_STATFS] = "statfs",
+	[SCOUTFS_NET_CMD_FAREWELL] = "farewell",
+	[SCOUTFS_NET_CMD_LOCK_BATCH] = "lock_batch",
+};
+
+/*
+ * Each command has log2 histograms of the microseconds between sending
+ * requests and receiving their responses, and between receiving
+ * requests and finishing processing them.  Bucket 0 counts latencies
+ * under 1us and bucket b counts latencies under 2^b us.  The
+ * histograms are per-cpu so recording is a lock-free increment.
+ */
+enum net_lat_kind {
+	NET_LAT_REQUEST = 0,
+	NET_LAT_PROCESS,
+	NET_LAT_NR,
+};
+
+#define NET_LAT_BUCKETS		32
+
+static char *net_lat_kind_names[] = {
+	[NET_LAT_REQUEST] = "request",
+	[NET_LAT_PROCESS] = "process",
+};
+
+struct net_lat_hist {
+	u64 buckets[NET_LAT_BUCKETS];
+};
+
+#define NET_LAT_HISTS	(NET_LAT_NR * SCOUTFS_NET_CMD_UNKNOWN)
+
+/* messages in the server's proc workqueues, reported in sysfs */
+struct net_cmd_stats {
+	atomic_t depth;
+	atomic64_t processed;
+	atomic64_t wait_ns;
+	atomic64_t proc_ns;
+};
+
 struct net_info {
 	struct workqueue_struct *shutdown_workq;
 	struct workqueue_struct *destroy_workq;
+	struct workqueue_struct *proc_workqs[NET_PROC_NR];
+	struct net_cmd_stats cmd_stats[SCOUTFS_NET_CMD_UNKNOWN];
+	struct net_lat_hist __percpu *lat_hists;
 	struct dentry *conn_tseq_dentry;
 	struct scoutfs_tseq_tree conn_tseq_tree;
 	struct dentry *msg_tseq_dentry;
 	struct scoutfs_tseq_tree msg_tseq_tree;
+	struct scoutfs_sysfs_attrs ssa;
 };
 
+#define DECLARE_NET_INFO_KOBJ(kobj, name) \
+	struct net_info *name = SCOUTFS_SB(SCOUTFS_SYSFS_ATTRS_SB(kobj))->net_info
+
 /* flags enum is in net.h */
 #define test_conn_fl(conn, which) (!!((conn)->flags & CONN_FL_##which))
 #define set_conn_fl(conn, which)				\
@@ -117,11 +209,17 @@ enum spin_lock_subtype {
  * message down the socket.  To free messages we mark them dead and have
  * the send worker free them while under the lock so that we don't have
  * to risk freeing messages from under the unlocked send worker.
+ *
+ * Requests that are waiting for their response are also in the
+ * connection's request hash.  They're removed from the hash as they're
+ * marked dead.
  */
 struct message_send {
 	struct scoutfs_tseq_entry tseq_entry;
 	unsigned long dead:1;
 	struct list_head head;
+	struct hlist_node req_node;
+	ktime_t submitted;
 	scoutfs_net_response_t resp_func;
 	void *resp_data;
 	struct scoutfs_net_header nh;
@@ -129,15 +227,26 @@ struct message_send {
 
 /*
  * Incoming received messages are processed in concurrent blocking work
- * contexts.
+ * contexts.  Payloads are small and bounded so every message is
+ * allocated from the connection's mempool of max size messages.
  */
 struct message_recv {
 	struct scoutfs_tseq_entry tseq_entry;
 	struct work_struct proc_work;
 	struct scoutfs_net_connection *conn;
+	ktime_t received;
+	u8 proc_class;
 	struct scoutfs_net_header nh;
 };
 
+#define MRECV_MAX_BYTES \
+	offsetof(struct message_recv, nh.data[SCOUTFS_NET_MAX_DATA_LEN])
+
+/* enough to keep receiving while earlier messages are processed */
+#define NET_RECV_POOL_MIN	16
+
+static struct kmem_cache *scoutfs_net_recv_cachep;
+
 #define DEFINE_CONN_FROM_WORK(name, work, member)			\
 	struct scoutfs_net_connection *name =				\
 		container_of(work, struct scoutfs_net_connection, member)
@@ -158,21 +267,56 @@ static bool nh_is_request(struct scoutfs_net_header *nh)
 	return !nh_is_response(nh);
 }
 
+static void record_latency(struct super_block *sb, int kind, u8 cmd,
+			   ktime_t start)
+{
+	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
+	s64 us = ktime_us_delta(ktime_get(), start);
+	int b;
+
+	b = us > 0 ? min_t(int, fls64(us), NET_LAT_BUCKETS - 1) : 0;
+
+	this_cpu_inc(ninf->lat_hists[(kind * SCOUTFS_NET_CMD_UNKNOWN) +
+				     cmd].buckets[b]);
+}
+
+/* ids are per-connection so the cmd rarely distinguishes requests */
+static u64 req_hash_key(u8 cmd, u64 id)
+{
+	return id ^ ((u64)cmd << 56);
+}
+
+static void hash_request(struct scoutfs_net_connection *conn,
+			 struct message_send *msend)
+{
+	assert_spin_locked(&conn->lock);
+
+	hash_add(conn->req_hash, &msend->req_node,
+		 req_hash_key(msend->nh.cmd, le64_to_cpu(msend->nh.id)));
+}
+
+static void unhash_request(struct message_send *msend)
+{
+	if (!hlist_unhashed(&msend->req_node))
+		hash_del(&msend->req_node);
+}
+
 /*
- * We return dead requests so that the caller can stop searching other
- * lists for the dead request that we found.
+ * Find an active send request in the hash.  It's almost certainly
+ * waiting on the resend queue but it could be actively being sent.
+ * Dead requests have already been removed from the hash.
  */
-static struct message_send *search_list(struct scoutfs_net_connection *conn,
-					struct list_head *list,
-					u8 cmd, u64 id)
+static struct message_send *find_request(struct scoutfs_net_connection *conn,
+					 u8 cmd, u64 id)
 {
 	struct message_send *msend;
 
 	assert_spin_locked(&conn->lock);
 
-	list_for_each_entry(msend, list, head) {
-		if (nh_is_request(&msend->nh) && msend->nh.cmd == cmd &&
-		    le64_to_cpu(msend->nh.id) == id)
+	hash_for_each_possible(conn->req_hash, msend, req_node,
+			       req_hash_key(cmd, id)) {
+		if (msend->nh.cmd == cmd && le64_to_cpu(msend->nh.id) == id &&
+		    !WARN_ON_ONCE(msend->dead))
 			return msend;
 	}
 
@@ -180,19 +324,25 @@ static struct message_send *search_list(struct scoutfs_net_connection *conn,
 }
 
 /*
- * Find an active send request on the lists.  It's almost certainly
- * waiting on the resend queue but it could be actively being sent.
+ * Find the accepted connection for a rid.  Connections are only hashed
+ * once they've received a valid greeting with the client's rid.  A
+ * reconnecting client can briefly have an old connection hashed and
+ * we'll find the most recently added connection first.
  */
-static struct message_send *find_request(struct scoutfs_net_connection *conn,
-					 u8 cmd, u64 id)
+static struct scoutfs_net_connection *
+find_accepted(struct scoutfs_net_connection *listener, u64 rid)
 {
-	struct message_send *msend;
+	struct scoutfs_net_connection *acc;
 
-	msend = search_list(conn, &conn->resend_queue, cmd, id) ?:
-		search_list(conn, &conn->send_queue, cmd, id);
-	if (msend && msend->dead)
-		msend = NULL;
-	return msend;
+	assert_spin_locked(&listener->lock);
+
+	hash_for_each_possible(listener->accepted_hash, acc, accepted_hnode,
+			       rid) {
+		if (acc->rid == rid)
+			return acc;
+	}
+
+	return NULL;
 }
 
 /*
@@ -209,6 +359,7 @@ static void complete_send(struct scoutfs_net_connection *conn,
 		return;
 
 	msend->dead = 1;
+	unhash_request(msend);
 	list_move(&msend->head, &conn->send_queue);
 	queue_work(conn->workq, &conn->send_work);
 }
@@ -308,7 +459,7 @@ static void shutdown_conn(struct scoutfs_net_connection *conn)
  *
  * If a non-zero rid is specified then the conn argument is a listening
  * connection and the connection to send the message down is found by
- * searching for the rid in its accepted connections.
+ * looking up the rid in its hash of accepted connections.
  */
 static int submit_send(struct super_block *sb,
 		       struct scoutfs_net_connection *conn, u64 rid,
@@ -342,22 +493,16 @@ static int submit_send(struct super_block *sb,
 	spin_lock_nested(&conn->lock, CONN_LOCK_LISTENER);
 
 	if (rid != 0) {
-		list_for_each_entry(acc_conn, &conn->accepted_list,
-				    accepted_head) {
-			if (acc_conn->rid == rid) {
-				spin_lock_nested(&acc_conn->lock,
-						 CONN_LOCK_ACCEPTED);
-				spin_unlock(&conn->lock);
-				conn = acc_conn;
-				rid = 0;
-				break;
-			}
-		}
-		if (rid != 0) {
+		acc_conn = find_accepted(conn, rid);
+		if (!acc_conn) {
 			spin_unlock(&conn->lock);
 			kfree(msend);
 			return -ENOTCONN;
 		}
+
+		spin_lock_nested(&acc_conn->lock, CONN_LOCK_ACCEPTED);
+		spin_unlock(&conn->lock);
+		conn = acc_conn;
 	}
 
 	seq = conn->next_send_seq++;
@@ -367,6 +512,8 @@ static int submit_send(struct super_block *sb,
 	msend->resp_func = resp_func;
 	msend->resp_data = resp_data;
 	msend->dead = 0;
+	INIT_HLIST_NODE(&msend->req_node);
+	msend->submitted = ktime_get();
 
 	msend->nh.seq = cpu_to_le64(seq);
 	msend->nh.recv_seq = 0;  /* set when sent, not when queued */
@@ -379,6 +526,9 @@ static int submit_send(struct super_block *sb,
 	if (data_len)
 		memcpy(msend->nh.data, data, data_len);
 
+	if (nh_is_request(&msend->nh))
+		hash_request(conn, msend);
+
 	if (test_conn_fl(conn, established) &&
 	    (test_conn_fl(conn, valid_greeting) ||
 	     cmd == SCOUTFS_NET_CMD_GREETING)) {
@@ -454,6 +604,8 @@ static int process_response(struct scoutfs_net_connection *conn,
 
 	msend = find_request(conn, mrecv->nh.cmd, le64_to_cpu(mrecv->nh.id));
 	if (msend) {
+		record_latency(sb, NET_LAT_REQUEST, msend->nh.cmd,
+			       msend->submitted);
 		resp_func = msend->resp_func;
 		resp_data = msend->resp_data;
 		complete_send(conn, msend);
@@ -467,6 +619,67 @@ static int process_response(struct scoutfs_net_connection *conn,
 			      le16_to_cpu(mrecv->nh.data_len), net_err_to_host(mrecv->nh.error));
 }
 
+static u8 cmd_proc_class(u8 cmd)
+{
+	switch (cmd) {
+	case SCOUTFS_NET_CMD_LOCK:
+	case SCOUTFS_NET_CMD_LOCK_BATCH:
+	case SCOUTFS_NET_CMD_LOCK_RECOVER:
+	case SCOUTFS_NET_CMD_GET_ROOTS:
+	case SCOUTFS_NET_CMD_GET_LAST_SEQ:
+		return NET_PROC_LOCK;
+
+	case SCOUTFS_NET_CMD_ALLOC_INODES:
+	case SCOUTFS_NET_CMD_GET_LOG_TREES:
+	case SCOUTFS_NET_CMD_COMMIT_LOG_TREES:
+	case SCOUTFS_NET_CMD_SRCH_GET_COMPACT:
+	case SCOUTFS_NET_CMD_SRCH_COMMIT_COMPACT:
+	case SCOUTFS_NET_CMD_GET_LOG_MERGE:
+	case SCOUTFS_NET_CMD_COMMIT_LOG_MERGE:
+	case SCOUTFS_NET_CMD_SET_VOLOPT:
+	case SCOUTFS_NET_CMD_CLEAR_VOLOPT:
+	case SCOUTFS_NET_CMD_RESIZE_DEVICES:
+		return NET_PROC_BULK;
+
+	default:
+		return NET_PROC_NORMAL;
+	}
+}
+
+/*
+ * Queue a received message for processing.  Accepted server connections
+ * queue messages in the shared workqueue for their command's class and
+ * count them so that shutdown can wait for them.
+ */
+static void queue_proc(struct scoutfs_net_connection *conn,
+		       struct message_recv *mrecv)
+{
+	struct net_info *ninf = SCOUTFS_SB(conn->sb)->net_info;
+	u8 cmd = mrecv->nh.cmd;
+
+	if (!conn->listening_conn) {
+		mrecv->proc_class = NET_PROC_CONN;
+		queue_work(conn->workq, &mrecv->proc_work);
+		return;
+	}
+
+	mrecv->proc_class = cmd_proc_class(cmd);
+	atomic_inc(&conn->proc_pending);
+	atomic_inc(&ninf->cmd_stats[cmd].depth);
+	queue_work(ninf->proc_workqs[mrecv->proc_class], &mrecv->proc_work);
+}
+
+static bool no_proc_pending(struct scoutfs_net_connection *conn)
+{
+	bool none;
+
+	spin_lock(&conn->lock);
+	none = atomic_read(&conn->proc_pending) == 0;
+	spin_unlock(&conn->lock);
+
+	return none;
+}
+
 /*
  * Process an incoming received message in its own concurrent blocking
  * work context.
@@ -478,23 +691,48 @@ static void scoutfs_net_proc_worker(struct work_struct *work)
 	struct scoutfs_net_connection *conn = mrecv->conn;
 	struct super_block *sb = conn->sb;
 	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
+	struct net_cmd_stats *stats = NULL;
+	ktime_t start;
 	int ret;
 
 	trace_scoutfs_net_proc_work_enter(sb, 0, 0);
 
-	if (nh_is_request(&mrecv->nh))
+	if (mrecv->proc_class != NET_PROC_CONN) {
+		stats = &ninf->cmd_stats[mrecv->nh.cmd];
+		start = ktime_get();
+		atomic_dec(&stats->depth);
+		atomic64_add(ktime_to_ns(ktime_sub(start, mrecv->received)),
+			     &stats->wait_ns);
+	}
+
+	if (nh_is_request(&mrecv->nh)) {
 		ret = process_request(conn, mrecv);
-	else
+		record_latency(sb, NET_LAT_PROCESS, mrecv->nh.cmd,
+			       mrecv->received);
+	} else {
 		ret = process_response(conn, mrecv);
+	}
 
 	/* process_one_work explicitly allows freeing work in its func */
 	scoutfs_tseq_del(&ninf->msg_tseq_tree, &mrecv->tseq_entry);
-	kfree(mrecv);
+	mempool_free(mrecv, conn->recv_pool);
 
 	/* shut down the connection if processing returns fatal errors */
 	if (ret)
 		shutdown_conn(conn);
 
+	/* shutdown can free the conn once it sees the final pending dec */
+	if (stats) {
+		atomic64_inc(&stats->processed);
+		atomic64_add(ktime_to_ns(ktime_sub(ktime_get(), start)),
+			     &stats->proc_ns);
+
+		spin_lock(&conn->lock);
+		if (atomic_dec_and_test(&conn->proc_pending))
+			wake_up(&conn->waitq);
+		spin_unlock(&conn->lock);
+	}
+
 	trace_scoutfs_net_proc_work_exit(sb, 0, ret);
 }
 
@@ -541,33 +779,34 @@ static void free_acked_responses(struct scoutfs_net_connection *conn, u64 seq)
 		queue_work(conn->workq, &conn->send_work);
 }
 
-static int recvmsg_full(struct socket *sock, void *buf, unsigned len)
+/*
+ * Block receiving at least one byte and return however many bytes were
+ * received, up to len.
+ */
+static int recvmsg_some(struct super_block *sb, struct socket *sock,
+			void *buf, unsigned len)
 {
 	struct msghdr msg;
 	struct kvec kv;
 	int ret;
 
-	while (len) {
-		memset(&msg, 0, sizeof(msg));
-		msg.msg_flags = MSG_NOSIGNAL;
-		kv.iov_base = buf;
-		kv.iov_len = len;
+	memset(&msg, 0, sizeof(msg));
+	msg.msg_flags = MSG_NOSIGNAL;
+	kv.iov_base = buf;
+	kv.iov_len = len;
 
 #ifndef KC_MSGHDR_STRUCT_IOV_ITER
-		msg.msg_iov = (struct iovec *)&kv;
-		msg.msg_iovlen = 1;
+	msg.msg_iov = (struct iovec *)&kv;
+	msg.msg_iovlen = 1;
 #else
-		iov_iter_init(&msg.msg_iter, READ, (struct iovec *)&kv, len, 1);
+	iov_iter_init(&msg.msg_iter, READ, (struct iovec *)&kv, 1, len);
 #endif
-		ret = kernel_recvmsg(sock, &msg, &kv, 1, len, msg.msg_flags);
-		if (ret <= 0)
-			return -ECONNABORTED;
+	scoutfs_inc_counter(sb, net_recv_recvmsg);
+	ret = kernel_recvmsg(sock, &msg, &kv, 1, len, msg.msg_flags);
+	if (ret <= 0)
+		return -ECONNABORTED;
 
-		len -= ret;
-		buf += ret;
-	}
-
-	return 0;
+	return ret;
 }
 
 static bool invalid_message(struct scoutfs_net_connection *conn,
@@ -604,96 +843,159 @@ static bool invalid_message(struct scoutfs_net_connection *conn,
 	return false;
 }
 
+/*
+ * Process a complete message that was received in the recv buffer.  The
+ * header has already been validated.  The message is copied out of the
+ * recv buffer into a pool allocation which is freed once it's processed.
+ *
+ * We can't block waiting for the pool to be refilled because the
+ * messages that would free pool elements can be waiting for responses
+ * that only this receive worker can deliver.  Once the pool's reserve
+ * is used we fall back to a blocking allocation from its slab cache
+ * which only waits for memory, mempool_free() frees it back to the
+ * cache.  Failing that shuts down the connection and the sender
+ * resends after reconnecting.
+ */
+static int recv_message(struct scoutfs_net_connection *conn,
+			struct scoutfs_net_header *nh, void *data)
+{
+	struct super_block *sb = conn->sb;
+	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
+	struct message_recv *mrecv;
+	unsigned int data_len = le16_to_cpu(nh->data_len);
+
+	scoutfs_inc_counter(sb, net_recv_messages);
+	scoutfs_add_counter(sb, net_recv_bytes, nh_bytes(data_len));
+	trace_scoutfs_net_recv_message(sb, &conn->sockname,
+				       &conn->peername, nh);
+
+	/* drop any resent duplicated messages */
+	if (nh->cmd != SCOUTFS_NET_CMD_GREETING &&
+	    le64_to_cpu(nh->seq) <= atomic64_read(&conn->recv_seq)) {
+		scoutfs_inc_counter(sb, net_recv_dropped_duplicate);
+		return 0;
+	}
+
+	/* allocate before recording the seq so failure doesn't lose the message */
+	mrecv = mempool_alloc(conn->recv_pool, GFP_NOWAIT | __GFP_NOWARN);
+	if (!mrecv) {
+		mrecv = kmem_cache_alloc(scoutfs_net_recv_cachep, GFP_NOFS);
+		if (!mrecv)
+			return -ENOMEM;
+	}
+
+	if (nh->cmd == SCOUTFS_NET_CMD_GREETING) {
+		/* greetings are out of band, no seq mechanics */
+		set_conn_fl(conn, saw_greeting);
+	} else {
+		/* record that we've received sender's seq */
+		atomic64_set(&conn->recv_seq, le64_to_cpu(nh->seq));
+		/* and free our responses that sender has received */
+		free_acked_responses(conn, le64_to_cpu(nh->recv_seq));
+	}
+
+	mrecv->conn = conn;
+	INIT_WORK(&mrecv->proc_work, scoutfs_net_proc_worker);
+	mrecv->received = ktime_get();
+	mrecv->proc_class = NET_PROC_CONN;
+	mrecv->nh = *nh;
+	memcpy(mrecv->nh.data, data, data_len);
+
+	scoutfs_tseq_add(&ninf->msg_tseq_tree, &mrecv->tseq_entry);
+
+	/*
+	 * Initial received greetings are processed
+	 * synchronously before any other incoming messages.
+	 *
+	 * Incoming requests or responses to the lock client are
+	 * called synchronously to avoid reordering.
+	 */
+	if (nh->cmd == SCOUTFS_NET_CMD_GREETING ||
+	    ((nh->cmd == SCOUTFS_NET_CMD_LOCK ||
+	      nh->cmd == SCOUTFS_NET_CMD_LOCK_BATCH) && !conn->listening_conn))
+		scoutfs_net_proc_worker(&mrecv->proc_work);
+	else
+		queue_proc(conn, mrecv);
+
+	return 0;
+}
+
+/* large enough to receive many max size messages in each recvmsg */
+#define NET_RECV_BUF_SIZE	(16 * 1024)
+
 /*
  * Always block receiving from the socket.  Errors trigger shutting down
  * the connection.
+ *
+ * We receive as much as the socket has available into a buffer and
+ * then process all the complete messages in the buffer.  A trailing
+ * partial message is moved to the front of the buffer and is completed
+ * by the next receive.
  */
 static void scoutfs_net_recv_worker(struct work_struct *work)
 {
 	DEFINE_CONN_FROM_WORK(conn, work, recv_work);
 	struct super_block *sb = conn->sb;
-	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
 	struct socket *sock = conn->sock;
 	struct scoutfs_net_header nh;
-	struct message_recv *mrecv;
-	unsigned int data_len;
+	unsigned int head = 0;
+	unsigned int tail = 0;
+	unsigned int bytes;
+	void *buf;
 	int ret;
 
+	BUILD_BUG_ON(NET_RECV_BUF_SIZE < sizeof(struct scoutfs_net_header) +
+					 SCOUTFS_NET_MAX_DATA_LEN);
+
 	trace_scoutfs_net_recv_work_enter(sb, 0, 0);
 
+	buf = kmalloc(NET_RECV_BUF_SIZE, GFP_NOFS);
+	if (!buf) {
+		ret = -ENOMEM;
+		goto out;
+	}
+
 	for (;;) {
-		/* receive the header */
-		ret = recvmsg_full(sock, &nh, sizeof(nh));
-		if (ret)
+		ret = recvmsg_some(sb, sock, buf + tail,
+				   NET_RECV_BUF_SIZE - tail);
+		if (ret < 0)
 			break;
+		tail += ret;
+		ret = 0;
 
-		/* receiving an invalid message breaks the connection */
-		if (invalid_message(conn, &nh)) {
-			scoutfs_inc_counter(sb, net_recv_invalid_message);
-			ret = -EBADMSG;
-			break;
-		}
+		while (tail - head >= sizeof(nh)) {
+			/* the header in the buffer can be unaligned */
+			memcpy(&nh, buf + head, sizeof(nh));
 
-		data_len = le16_to_cpu(nh.data_len);
+			/* receiving an invalid message breaks the connection */
+			if (invalid_message(conn, &nh)) {
+				scoutfs_inc_counter(sb, net_recv_invalid_message);
+				ret = -EBADMSG;
+				break;
+			}
 
-		scoutfs_inc_counter(sb, net_recv_messages);
-		scoutfs_add_counter(sb, net_recv_bytes, nh_bytes(data_len));
-		trace_scoutfs_net_recv_message(sb, &conn->sockname,
-					       &conn->peername, &nh);
+			/* invalid message checked data len */
+			bytes = nh_bytes(le16_to_cpu(nh.data_len));
+			if (tail - head < bytes)
+				break;
 
-		/* invalid message checked data len */
-		mrecv = kmalloc(offsetof(struct message_recv,
-					 nh.data[data_len]), GFP_NOFS);
-		if (!mrecv) {
-			ret = -ENOMEM;
-			break;
+			ret = recv_message(conn, &nh, buf + head + sizeof(nh));
+			if (ret < 0)
+				break;
+			head += bytes;
 		}
-
-		mrecv->conn = conn;
-		INIT_WORK(&mrecv->proc_work, scoutfs_net_proc_worker);
-		mrecv->nh = nh;
-
-		/* receive the data payload */
-		ret = recvmsg_full(sock, mrecv->nh.data, data_len);
-		if (ret) {
-			kfree(mrecv);
+		if (ret)
 			break;
-		}
 
-		if (nh.cmd == SCOUTFS_NET_CMD_GREETING) {
-			/* greetings are out of band, no seq mechanics */
-			set_conn_fl(conn, saw_greeting);
-
-		} else if (le64_to_cpu(nh.seq) <=
-			   atomic64_read(&conn->recv_seq)) {
-			/* drop any resent duplicated messages */
-			scoutfs_inc_counter(sb, net_recv_dropped_duplicate);
-			kfree(mrecv);
-			continue;
-
-		} else {
-			/* record that we've received sender's seq */
-			atomic64_set(&conn->recv_seq, le64_to_cpu(nh.seq));
-			/* and free our responses that sender has received */
-			free_acked_responses(conn, le64_to_cpu(nh.recv_seq));
+		if (head > 0) {
+			memmove(buf, buf + head, tail - head);
+			tail -= head;
+			head = 0;
 		}
-
-		scoutfs_tseq_add(&ninf->msg_tseq_tree, &mrecv->tseq_entry);
-
-		/*
-		 * Initial received greetings are processed
-		 * synchronously before any other incoming messages.
-		 *
-		 * Incoming requests or responses to the lock client are
-		 * called synchronously to avoid reordering.
-		 */
-		if (nh.cmd == SCOUTFS_NET_CMD_GREETING ||
-		    (nh.cmd == SCOUTFS_NET_CMD_LOCK && !conn->listening_conn))
-			scoutfs_net_proc_worker(&mrecv->proc_work);
-		else
-			queue_work(conn->workq, &mrecv->proc_work);
 	}
 
+	kfree(buf);
+out:
 	if (ret)
 		scoutfs_inc_counter(sb, net_recv_error);
 
@@ -703,30 +1005,44 @@ static void scoutfs_net_recv_worker(struct work_struct *work)
 	trace_scoutfs_net_recv_work_exit(sb, 0, ret);
 }
 
-static int sendmsg_full(struct socket *sock, void *buf, unsigned len)
+/*
+ * Send all the bytes in the vector, advancing through the vector as
+ * partial sends are made.  The caller's vector is modified.  The caller
+ * can set more to cork the socket when it knows that it's about to send
+ * more messages.
+ */
+static int sendmsg_full(struct super_block *sb, struct socket *sock,
+			struct kvec *kv, unsigned nr, unsigned len, bool more)
 {
 	struct msghdr msg;
-	struct kvec kv;
 	int ret;
 
 	while (len) {
 		memset(&msg, 0, sizeof(msg));
-		msg.msg_flags = MSG_NOSIGNAL;
-		kv.iov_base = buf;
-		kv.iov_len = len;
+		msg.msg_flags = MSG_NOSIGNAL | (more ? MSG_MORE : 0);
 
 #ifndef KC_MSGHDR_STRUCT_IOV_ITER
-		msg.msg_iov = (struct iovec *)&kv;
-		msg.msg_iovlen = 1;
+		msg.msg_iov = (struct iovec *)kv;
+		msg.msg_iovlen = nr;
 #else
-		iov_iter_init(&msg.msg_iter, WRITE, (struct iovec *)&kv, len, 1);
+		iov_iter_init(&msg.msg_iter, WRITE, (struct iovec *)kv, nr, len);
 #endif
-		ret = kernel_sendmsg(sock, &msg, &kv, 1, len);
+		scoutfs_inc_counter(sb, net_send_sendmsg);
+		ret = kernel_sendmsg(sock, &msg, kv, nr, len);
 		if (ret <= 0)
 			return -ECONNABORTED;
 
 		len -= ret;
-		buf += ret;
+
+		while (ret > 0 && ret >= kv->iov_len) {
+			ret -= kv->iov_len;
+			kv++;
+			nr--;
+		}
+		if (ret > 0) {
+			kv->iov_base += ret;
+			kv->iov_len -= ret;
+		}
 	}
 
 	return 0;
@@ -735,10 +1051,13 @@ static int sendmsg_full(struct socket *sock, void *buf, unsigned len)
 static void free_msend(struct net_info *ninf, struct message_send *msend)
 {
 	list_del_init(&msend->head);
+	unhash_request(msend);
 	scoutfs_tseq_del(&ninf->msg_tseq_tree, &msend->tseq_entry);
 	kfree(msend);
 }
 
+#define NET_SEND_BATCH_NR	16
+
 /*
  * Each connection has a single worker that sends queued messages down
  * the connection's socket.  The work is queued whenever a message is
@@ -750,6 +1069,11 @@ static void free_msend(struct net_info *ninf, struct message_send *msend)
  * don't have to worry about freeing a message while we're blocked
  * sending it without the lock held.
  *
+ * We gather a batch of the messages at the front of the send queue and
+ * send them all with one sendmsg call.  The messages stay at the front
+ * of the send queue while we send without the lock.  New messages are
+ * only added to the tail and other contexts only mark messages dead.
+ *
  * We set the current recv_seq on every outgoing frame as it represents
  * the current connection state, not the state back when each message
  * was first queued.
@@ -759,51 +1083,79 @@ static void scoutfs_net_send_worker(struct work_struct *work)
 	DEFINE_CONN_FROM_WORK(conn, work, send_work);
 	struct super_block *sb = conn->sb;
 	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
+	struct message_send *msends[NET_SEND_BATCH_NR];
+	struct kvec kvs[NET_SEND_BATCH_NR];
 	struct message_send *msend;
+	struct message_send *tmp;
+	unsigned int total;
+	bool more;
 	int ret = 0;
 	int len;
+	int nr;
+	int i;
 
 	trace_scoutfs_net_send_work_enter(sb, 0, 0);
 
 	spin_lock(&conn->lock);
 
-	while ((msend = list_first_entry_or_null(&conn->send_queue,
-						 struct message_send, head))) {
+	for (;;) {
+		nr = 0;
+		total = 0;
+		list_for_each_entry_safe(msend, tmp, &conn->send_queue, head) {
+			if (msend->dead) {
+				free_msend(ninf, msend);
+				continue;
+			}
 
-		if (msend->dead) {
-			free_msend(ninf, msend);
-			continue;
-		}
+			if ((msend->nh.cmd == SCOUTFS_NET_CMD_FAREWELL) &&
+			    nh_is_response(&msend->nh)) {
+				set_conn_fl(conn, saw_farewell);
+			}
+
+			msend->nh.recv_seq =
+				cpu_to_le64(atomic64_read(&conn->recv_seq));
 
-		if ((msend->nh.cmd == SCOUTFS_NET_CMD_FAREWELL) &&
-		    nh_is_response(&msend->nh)) {
-			set_conn_fl(conn, saw_farewell);
+			len = nh_bytes(le16_to_cpu(msend->nh.data_len));
+			msends[nr] = msend;
+			kvs[nr].iov_base = &msend->nh;
+			kvs[nr].iov_len = len;
+			total += len;
+
+			if (++nr == NET_SEND_BATCH_NR)
+				break;
 		}
 
-		msend->nh.recv_seq =
-			cpu_to_le64(atomic64_read(&conn->recv_seq));
+		if (nr == 0)
+			break;
 
-		spin_unlock(&conn->lock);
+		/* cork if we couldn't fit all the queued messages in the batch */
+		more = !list_is_last(&msends[nr - 1]->head, &conn->send_queue);
 
-		len = nh_bytes(le16_to_cpu(msend->nh.data_len));
+		spin_unlock(&conn->lock);
 
-		scoutfs_inc_counter(sb, net_send_messages);
-		scoutfs_add_counter(sb, net_send_bytes, len);
-		trace_scoutfs_net_send_message(sb, &conn->sockname,
-					       &conn->peername, &msend->nh);
+		for (i = 0; i < nr; i++) {
+			scoutfs_inc_counter(sb, net_send_messages);
+			scoutfs_add_counter(sb, net_send_bytes, kvs[i].iov_len);
+			trace_scoutfs_net_send_message(sb, &conn->sockname,
+						       &conn->peername,
+						       &msends[i]->nh);
+		}
 
-		ret = sendmsg_full(conn->sock, &msend->nh, len);
+		ret = sendmsg_full(sb, conn->sock, kvs, nr, total, more);
 
 		spin_lock(&conn->lock);
 
-		msend->nh.recv_seq = 0;
+		for (i = 0; i < nr; i++) {
+			msend = msends[i];
+			msend->nh.recv_seq = 0;
+
+			/* resend if it wasn't freed while we sent */
+			if (ret == 0 && !msend->dead)
+				list_move_tail(&msend->head, &conn->resend_queue);
+		}
 
 		if (ret)
 			break;
-
-		/* resend if it wasn't freed while we sent */
-		if (!msend->dead)
-			list_move_tail(&msend->head, &conn->resend_queue);
 	}
 
 	spin_unlock(&conn->lock);
@@ -839,6 +1191,7 @@ static void scoutfs_net_destroy_worker(struct work_struct *work)
 
 	WARN_ON_ONCE(conn->sock != NULL);
 	WARN_ON_ONCE(!list_empty(&conn->accepted_list));
+	WARN_ON_ONCE(atomic_read(&conn->proc_pending) != 0);
 
 	/* tell callers that accepted connection finally done */
 	if (conn->listening_conn && conn->notify_down)
@@ -854,12 +1207,15 @@ static void scoutfs_net_destroy_worker(struct work_struct *work)
 
 		spin_lock(&listener->lock);
 		list_del_init(&conn->accepted_head);
+		if (!hlist_unhashed(&conn->accepted_hnode))
+			hash_del(&conn->accepted_hnode);
 		if (list_empty(&listener->accepted_list))
 			wake_up(&listener->waitq);
 		spin_unlock(&listener->lock);
 	}
 
 	destroy_workqueue(conn->workq);
+	mempool_destroy(conn->recv_pool);
 	scoutfs_tseq_del(&ninf->conn_tseq_tree, &conn->tseq_entry);
 	kfree(conn->info);
 	trace_scoutfs_conn_destroy_free(conn);
@@ -1154,6 +1510,10 @@ static void scoutfs_net_shutdown_worker(struct work_struct *work)
 	if (conn->sock)
 		kernel_sock_shutdown(conn->sock, SHUT_RDWR);
 
+	/* stop receiving and wait for proc work in the server's workqueues */
+	flush_work(&conn->recv_work);
+	wait_event(conn->waitq, no_proc_pending(conn));
+
 	/* wait for socket and proc work to finish, includes chained work */
 	drain_workqueue(conn->workq);
 
@@ -1356,10 +1716,19 @@ scoutfs_net_alloc_conn(struct super_block *sb,
 		}
 	}
 
+	conn->recv_pool = mempool_create_slab_pool(NET_RECV_POOL_MIN,
+						   scoutfs_net_recv_cachep);
+	if (!conn->recv_pool) {
+		kfree(conn->info);
+		kfree(conn);
+		return NULL;
+	}
+
 	conn->workq = alloc_workqueue("scoutfs_net_%s",
 				      WQ_UNBOUND | WQ_NON_REENTRANT, 0,
 				      name_suffix);
 	if (!conn->workq) {
+		mempool_destroy(conn->recv_pool);
 		kfree(conn->info);
 		kfree(conn);
 		return NULL;
@@ -1376,12 +1745,16 @@ scoutfs_net_alloc_conn(struct super_block *sb,
 	conn->peername.sin_family = AF_INET;
 	conn->last_peername.sin_family = AF_INET;
 	INIT_LIST_HEAD(&conn->accepted_head);
+	INIT_HLIST_NODE(&conn->accepted_hnode);
 	INIT_LIST_HEAD(&conn->accepted_list);
+	hash_init(conn->accepted_hash);
 	conn->next_send_seq = 1;
 	conn->next_send_id = 1;
 	atomic64_set(&conn->recv_seq, 0);
+	atomic_set(&conn->proc_pending, 0);
 	INIT_LIST_HEAD(&conn->send_queue);
 	INIT_LIST_HEAD(&conn->resend_queue);
+	hash_init(conn->req_hash);
 	INIT_WORK(&conn->listen_work, scoutfs_net_listen_worker);
 	INIT_WORK(&conn->connect_work, scoutfs_net_connect_worker);
 	INIT_WORK(&conn->send_work, scoutfs_net_send_worker);
@@ -1637,18 +2010,19 @@ void scoutfs_net_server_greeting(struct super_block *sb,
 	struct scoutfs_net_connection *listener;
 	struct scoutfs_net_connection *reconn;
 	struct scoutfs_net_connection *acc;
+	struct message_send *msend;
 
 	/* only called on accepted server connections :/ */
 	BUG_ON(!conn->listening_conn);
+	listener = conn->listening_conn;
 
 	/* see if we have a previous conn for the client's sent rid */
 	reconn = NULL;
 	if (reconnecting) {
-		listener = conn->listening_conn;
 restart:
 		spin_lock_nested(&listener->lock, CONN_LOCK_LISTENER);
-		list_for_each_entry(acc, &listener->accepted_list,
-				    accepted_head) {
+		hash_for_each_possible(listener->accepted_hash, acc,
+				       accepted_hnode, rid) {
 			if (acc->rid != rid ||
 			    acc->greeting_id >= greeting_id ||
 			    test_conn_fl(acc, reconn_freeing))
@@ -1689,6 +2063,12 @@ restart:
 		/* reconn should be idle while in reconn_wait  */
 		BUG_ON(!list_empty(&reconn->send_queue));
 		/* queued greeting response is racing, can be in send or resend queue */
+		list_for_each_entry(msend, &reconn->resend_queue, head) {
+			if (!hlist_unhashed(&msend->req_node)) {
+				unhash_request(msend);
+				hash_request(conn, msend);
+			}
+		}
 		list_splice_tail_init(&reconn->resend_queue, &conn->resend_queue);
 
 		/* new conn info is unused, swap, old won't call down */
@@ -1702,13 +2082,17 @@ restart:
 		destroy_conn(reconn);
 	}
 
-	spin_lock(&conn->lock);
+	spin_lock_nested(&listener->lock, CONN_LOCK_LISTENER);
+	spin_lock_nested(&conn->lock, CONN_LOCK_ACCEPTED);
 
 	conn->rid = rid;
 	conn->greeting_id = greeting_id;
+	if (hlist_unhashed(&conn->accepted_hnode))
+		hash_add(listener->accepted_hash, &conn->accepted_hnode, rid);
 	set_valid_greeting(conn);
 
 	spin_unlock(&conn->lock);
+	spin_unlock(&listener->lock);
 
 	/* only call notify_up the first time we see the rid */
 	if (conn->notify_up && first_contact)
@@ -1900,6 +2284,87 @@ static void net_tseq_show_msg(struct seq_file *m,
 	}
 }
 
+static ssize_t proc_queues_show(struct kobject *kobj,
+				struct kobj_attribute *attr, char *buf)
+{
+	DECLARE_NET_INFO_KOBJ(kobj, ninf);
+	struct net_cmd_stats *stats;
+	ssize_t ret = 0;
+	u64 processed;
+	int depth;
+	int i;
+
+	for (i = 0; i < SCOUTFS_NET_CMD_UNKNOWN; i++) {
+		stats = &ninf->cmd_stats[i];
+		depth = atomic_read(&stats->depth);
+		processed = atomic64_read(&stats->processed);
+		if (depth == 0 && processed == 0)
+			continue;
+
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+				 "%s class %s depth %d processed %llu wait_ns %llu proc_ns %llu\n",
+				 net_cmd_names[i],
+				 net_proc_class_names[cmd_proc_class(i)],
+				 depth, processed,
+				 (u64)atomic64_read(&stats->wait_ns),
+				 (u64)atomic64_read(&stats->proc_ns));
+	}
+
+	return ret;
+}
+SCOUTFS_ATTR_RO(proc_queues);
+
+/*
+ * Output a line for each command's histogram that has recorded
+ * latencies.  Only the non-zero buckets are output as bucket:count.
+ */
+static ssize_t latency_show(struct kobject *kobj,
+			    struct kobj_attribute *attr, char *buf)
+{
+	DECLARE_NET_INFO_KOBJ(kobj, ninf);
+	u64 counts[NET_LAT_BUCKETS];
+	struct net_lat_hist *hist;
+	ssize_t ret = 0;
+	bool any;
+	int cpu;
+	int i;
+	int b;
+
+	for (i = 0; i < NET_LAT_HISTS; i++) {
+		memset(counts, 0, sizeof(counts));
+		any = false;
+
+		for_each_possible_cpu(cpu) {
+			hist = per_cpu_ptr(ninf->lat_hists + i, cpu);
+			for (b = 0; b < NET_LAT_BUCKETS; b++) {
+				counts[b] += hist->buckets[b];
+				any |= !!hist->buckets[b];
+			}
+		}
+		if (!any)
+			continue;
+
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret, "%s %s",
+				 net_lat_kind_names[i / SCOUTFS_NET_CMD_UNKNOWN],
+				 net_cmd_names[i % SCOUTFS_NET_CMD_UNKNOWN]);
+		for (b = 0; b < NET_LAT_BUCKETS; b++) {
+			if (counts[b])
+				ret += scnprintf(buf + ret, PAGE_SIZE - ret,
+						 " %d:%llu", b, counts[b]);
+		}
+		ret += scnprintf(buf + ret, PAGE_SIZE - ret, "\n");
+	}
+
+	return ret;
+}
+SCOUTFS_ATTR_RO(latency);
+
+static struct attribute *net_attrs[] = {
+	SCOUTFS_ATTR_PTR(proc_queues),
+	SCOUTFS_ATTR_PTR(latency),
+	NULL,
+};
+
 int scoutfs_net_setup(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
@@ -1910,6 +2375,7 @@ int scoutfs_net_setup(struct super_block *sb)
 #undef EXPAND_NET_ERRNO
 #define EXPAND_NET_ERRNO(which) BUILD_BUG_ON(which >= U8_MAX);
 	EXPAND_EACH_NET_ERRNO
+	BUILD_BUG_ON(ARRAY_SIZE(net_cmd_names) != SCOUTFS_NET_CMD_UNKNOWN);
 
 	ninf = kzalloc(sizeof(struct net_info), GFP_KERNEL);
 	if (!ninf) {
@@ -1918,6 +2384,7 @@ int scoutfs_net_setup(struct super_block *sb)
 	}
 	sbi->net_info = ninf;
 
+	scoutfs_sysfs_init_attrs(sb, &ninf->ssa);
 	scoutfs_tseq_tree_init(&ninf->conn_tseq_tree, net_tseq_show_conn);
 	scoutfs_tseq_tree_init(&ninf->msg_tseq_tree, net_tseq_show_msg);
 
@@ -1927,7 +2394,21 @@ int scoutfs_net_setup(struct super_block *sb)
 	ninf->destroy_workq = alloc_workqueue("scoutfs_net_destroy",
 					       WQ_UNBOUND | WQ_NON_REENTRANT,
 					       0);
-	if (!ninf->shutdown_workq || !ninf->destroy_workq) {
+	ninf->proc_workqs[NET_PROC_LOCK] =
+		alloc_workqueue("scoutfs_net_proc_lock",
+				WQ_UNBOUND | WQ_HIGHPRI, 0);
+	ninf->proc_workqs[NET_PROC_NORMAL] =
+		alloc_workqueue("scoutfs_net_proc_normal", WQ_UNBOUND, 0);
+	ninf->proc_workqs[NET_PROC_BULK] =
+		alloc_workqueue("scoutfs_net_proc_bulk", WQ_UNBOUND,
+				NET_PROC_BULK_MAX_ACTIVE);
+	ninf->lat_hists = __alloc_percpu(sizeof(struct net_lat_hist) *
+					 NET_LAT_HISTS,
+					 __alignof__(struct net_lat_hist));
+	if (!ninf->shutdown_workq || !ninf->destroy_workq || !ninf->lat_hists ||
+	    !ninf->proc_workqs[NET_PROC_LOCK] ||
+	    !ninf->proc_workqs[NET_PROC_NORMAL] ||
+	    !ninf->proc_workqs[NET_PROC_BULK]) {
 		ret = -ENOMEM;
 		goto out;
 	}
@@ -1948,6 +2429,10 @@ int scoutfs_net_setup(struct super_block *sb)
 		goto out;
 	}
 
+	ret = scoutfs_sysfs_create_attrs(sb, &ninf->ssa, net_attrs, "net");
+	if (ret < 0)
+		goto out;
+
 	ret = 0;
 out:
 	if (ret)
@@ -1959,15 +2444,41 @@ void scoutfs_net_destroy(struct super_block *sb)
 {
 	struct scoutfs_sb_info *sbi = SCOUTFS_SB(sb);
 	struct net_info *ninf = SCOUTFS_SB(sb)->net_info;
+	int i;
 
 	if (ninf) {
+		scoutfs_sysfs_destroy_attrs(sb, &ninf->ssa);
 		if (ninf->shutdown_workq)
 			destroy_workqueue(ninf->shutdown_workq);
 		if (ninf->destroy_workq)
 			destroy_workqueue(ninf->destroy_workq);
+		for (i = 0; i < NET_PROC_NR; i++) {
+			if (ninf->proc_workqs[i])
+				destroy_workqueue(ninf->proc_workqs[i]);
+		}
+		free_percpu(ninf->lat_hists);
 		debugfs_remove(ninf->conn_tseq_dentry);
 		debugfs_remove(ninf->msg_tseq_dentry);
 		kfree(ninf);
 		sbi->net_info = NULL;
 	}
 }
+
+void scoutfs_net_exit(void)
+{
+	if (scoutfs_net_recv_cachep) {
+		kmem_cache_destroy(scoutfs_net_recv_cachep);
+		scoutfs_net_recv_cachep = NULL;
+	}
+}
+
+int scoutfs_net_init(void)
+{
+	scoutfs_net_recv_cachep = kmem_cache_create("scoutfs_net_recv",
+						    MRECV_MAX_BYTES, 0, 0,
+						    NULL);
+	if (!scoutfs_net_recv_cachep)
+		return -ENOMEM;
+
+	return 0;
+}
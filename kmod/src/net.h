@@ -2,6 +2,8 @@
 #define _SCOUTFS_NET_H_
 
 #include <linux/in.h>
+#include <linux/hashtable.h>
+#include <linux/mempool.h>
 #include "endian_swap.h"
 #include "tseq.h"
 
@@ -22,6 +24,14 @@ typedef void (*scoutfs_net_notify_t)(struct super_block *sb,
 				     struct scoutfs_net_connection *conn,
 				     void *info, u64 rid);
 
+/*
+ * Outstanding requests are hashed by their cmd and id so that received
+ * responses can find them, and listeners hash their accepted
+ * connections by rid so that server sends can find their client.
+ */
+#define SCOUTFS_NET_REQ_HASH_BITS	8
+#define SCOUTFS_NET_ACCEPTED_HASH_BITS	6
+
 /*
  * The conn is only here so that tracing can get at its fields without
  * having trace functions with a trillion arguments.  Tracing requires
@@ -52,15 +62,20 @@ struct scoutfs_net_connection {
 	struct sockaddr_in last_peername;
 
 	struct list_head accepted_head;
+	struct hlist_node accepted_hnode;
 	struct scoutfs_net_connection *listening_conn;
 	struct list_head accepted_list;
+	DECLARE_HASHTABLE(accepted_hash, SCOUTFS_NET_ACCEPTED_HASH_BITS);
 
 	u64 next_send_seq;
 	u64 next_send_id;
 	struct list_head send_queue;
 	struct list_head resend_queue;
+	DECLARE_HASHTABLE(req_hash, SCOUTFS_NET_REQ_HASH_BITS);
 
 	atomic64_t recv_seq;
+	mempool_t *recv_pool;
+	atomic_t proc_pending;
 
 	struct workqueue_struct *workq;
 	struct work_struct listen_work;
@@ -163,5 +178,7 @@ void scoutfs_net_farewell(struct super_block *sb,
 
 int scoutfs_net_setup(struct super_block *sb);
 void scoutfs_net_destroy(struct super_block *sb);
+int scoutfs_net_init(void);
+void scoutfs_net_exit(void);
 
 #endif
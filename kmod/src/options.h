@@ -8,6 +8,9 @@
 struct scoutfs_mount_options {
 	u64 data_prealloc_blocks;
 	bool data_prealloc_contig_only;
+	unsigned int dir_index_lookups;
+	unsigned int lock_min_hold_ms;
+	bool lock_prefetch;
 	char *metadev_path;
 	unsigned int orphan_scan_delay_ms;
 	int quorum_slot_nr;
@@ -513,6 +513,38 @@ TRACE_EVENT(scoutfs_ioc_stage,
 		  __entry->offset, __entry->length)
 );
 
+TRACE_EVENT(scoutfs_ioc_stage_fd,
+	TP_PROTO(struct super_block *sb, u64 ino,
+		 struct scoutfs_ioctl_stage_fd *args),
+
+	TP_ARGS(sb, ino, args),
+
+	TP_STRUCT__entry(
+		SCSB_TRACE_FIELDS
+		__field(__u64, ino)
+		__field(__u64, vers)
+		__field(__u64, from_fd)
+		__field(__u64, from_off)
+		__field(__u64, offset)
+		__field(__u64, length)
+	),
+
+	TP_fast_assign(
+		SCSB_TRACE_ASSIGN(sb);
+		__entry->ino = ino;
+		__entry->vers = args->data_version;
+		__entry->from_fd = args->from_fd;
+		__entry->from_off = args->from_off;
+		__entry->offset = args->offset;
+		__entry->length = args->length;
+	),
+
+	TP_printk(SCSBF" ino %llu vers %llu from_fd %llu from_off %llu offset %llu length %llu",
+		  SCSB_TRACE_ARGS, __entry->ino, __entry->vers,
+		  __entry->from_fd, __entry->from_off, __entry->offset,
+		  __entry->length)
+);
+
 TRACE_EVENT(scoutfs_ioc_data_wait_err,
 	TP_PROTO(struct super_block *sb,
 		 struct scoutfs_ioctl_data_wait_err *args),
@@ -65,6 +65,8 @@ struct commit_users {
 	struct list_head holding;
 	struct list_head applying;
 	unsigned int nr_holders;
+	unsigned int nr_applying;
+	ktime_t apply_start;
 	u32 avail_before;
 	u32 freed_before;
 	bool committing;
@@ -156,11 +158,15 @@ struct server_info {
 #define DIRTY_SUPER_SB(sb)	(&SCOUTFS_SB(sb)->server_info->dirty_super)
 
 /*
- * The server tracks each connected client.
+ * The server tracks each connected client.  The consumed fields are
+ * moving averages of the allocator blocks that the client used in each
+ * of its recent transactions, protected by the logs_mutex.
  */
 struct server_client_info {
 	u64 rid;
 	struct list_head head;
+	u64 meta_consumed;
+	u64 data_consumed;
 };
 
 static __le64 *first_valopt(struct scoutfs_volume_options *valopt)
@@ -264,6 +270,16 @@ static void server_down(struct server_info *server)
  */
 #define COMMIT_HOLD_ALLOC_BUDGET 500
 
+/*
+ * Once the first holder of a commit starts applying, new holders can
+ * still join the commit for a short window while the remaining
+ * holders finish.  Without joining, a holder that arrives just after
+ * the first apply has to wait for the whole commit to be written before
+ * it can start its own.  The window bounds how long the first applier
+ * can be delayed by later arrivals.
+ */
+#define GROUP_COMMIT_JOIN_US 2000
+
 struct commit_hold {
 	struct list_head entry;
 	ktime_t start;
@@ -316,7 +332,7 @@ static void check_holder_budget(struct super_block *sb, struct server_info *serv
 	else
 		freed_used = SCOUTFS_ALLOC_LIST_MAX_BLOCKS - freed_now;
 
-	budget = cusers->nr_holders * COMMIT_HOLD_ALLOC_BUDGET;
+	budget = (cusers->nr_holders + cusers->nr_applying) * COMMIT_HOLD_ALLOC_BUDGET;
 	if (avail_used <= budget && freed_used <= budget)
 		return;
 
@@ -346,6 +362,7 @@ static bool hold_commit(struct super_block *sb, struct server_info *server,
 			struct commit_users *cusers, struct commit_hold *hold)
 {
 	bool has_room;
+	bool joining;
 	bool held;
 	u32 budget;
 	u32 av;
@@ -365,10 +382,13 @@ static bool hold_commit(struct super_block *sb, struct server_info *server,
 	}
 
 	/* +2 for our additional hold and then for the final commit work the server does */
-	budget = (cusers->nr_holders + 2) * COMMIT_HOLD_ALLOC_BUDGET;
+	budget = (cusers->nr_holders + cusers->nr_applying + 2) * COMMIT_HOLD_ALLOC_BUDGET;
 	has_room = av >= budget && fr >= budget;
-	/* checking applying so holders drain once an apply caller starts waiting */
-	held = !cusers->committing && has_room && list_empty(&cusers->applying);
+	/* checking applying so holders drain once the join window has passed */
+	joining = !list_empty(&cusers->applying);
+	held = !cusers->committing && has_room &&
+	       (!joining || ktime_before(ktime_get(), ktime_add_us(cusers->apply_start,
+								   GROUP_COMMIT_JOIN_US)));
 
 	if (held) {
 		if (cusers->nr_holders == 0) {
@@ -386,6 +406,8 @@ static bool hold_commit(struct super_block *sb, struct server_info *server,
 		list_add_tail(&hold->entry, &cusers->holding);
 
 		cusers->nr_holders++;
+		if (joining)
+			scoutfs_inc_counter(sb, server_commit_group_join);
 
 	} else if (!has_room && cusers->nr_holders == 0 && !cusers->committing) {
 		cusers->committing = true;
@@ -410,7 +432,10 @@ static void server_hold_commit(struct super_block *sb, struct commit_hold *hold)
 	BUG_ON(!list_empty(&hold->entry));
 
 	scoutfs_inc_counter(sb, server_commit_hold);
-	wait_event(cusers->waitq, hold_commit(sb, server, cusers, hold));
+	if (!hold_commit(sb, server, cusers, hold)) {
+		scoutfs_inc_counter(sb, server_commit_hold_stall);
+		wait_event(cusers->waitq, hold_commit(sb, server, cusers, hold));
+	}
 }
 
 /*
@@ -438,7 +463,10 @@ static int server_apply_commit(struct super_block *sb, struct commit_hold *hold,
 	}
 
 	if (err == 0) {
+		if (list_empty(&cusers->applying))
+			cusers->apply_start = ktime_get();
 		list_move_tail(&hold->entry, &cusers->applying);
+		cusers->nr_applying++;
 	} else {
 		list_del_init(&hold->entry);
 		hold->ret = err;
@@ -492,6 +520,8 @@ static void commit_end(struct super_block *sb, struct commit_users *cusers, int
 	smp_wmb(); /* ret stores before list updates */
 	list_for_each_entry_safe(hold, tmp, &cusers->applying, entry)
 		list_del_init(&hold->entry);
+	scoutfs_add_counter(sb, server_commit_group_holders, cusers->nr_applying);
+	cusers->nr_applying = 0;
 	cusers->committing = false;
 	spin_unlock(&cusers->lock);
 
@@ -663,6 +693,14 @@ out:
 	trace_scoutfs_server_commit_work_exit(sb, 0, ret);
 }
 
+/*
+ * Inode numbers are handed out in batches that start on an inode lock
+ * group boundary.  Lock groups are then only shared by mounts when a
+ * single batch is smaller than a group.  Without alignment each batch
+ * boundary would put the end of one mount's inodes and the start of
+ * another's in the same group and their creates would bounce the lock
+ * between the mounts.  The skipped inode numbers are never used.
+ */
 static int server_alloc_inodes(struct super_block *sb,
 			       struct scoutfs_net_connection *conn,
 			       u8 cmd, u64 id, void *arg, u16 arg_len)
@@ -687,8 +725,10 @@ static int server_alloc_inodes(struct super_block *sb,
 
 	spin_lock(&sbi->next_ino_lock);
 	ino = le64_to_cpu(super->next_ino);
+	if (ino <= (U64_MAX & ~(u64)SCOUTFS_LOCK_INODE_GROUP_MASK))
+		ino = round_up(ino, SCOUTFS_LOCK_INODE_GROUP_NR);
 	nr = min(le64_to_cpu(lecount), U64_MAX - ino);
-	le64_add_cpu(&super->next_ino, nr);
+	super->next_ino = cpu_to_le64(ino + nr);
 	spin_unlock(&sbi->next_ino_lock);
 
 	ret = server_apply_commit(sb, &hold, 0);
@@ -719,6 +759,64 @@ static int alloc_move_refill_zoned(struct super_block *sb, struct scoutfs_alloc_
 				  exclusive, vacant, zone_blocks, 0);
 }
 
+/*
+ * Size a client's data_avail refill from its recent consumption.
+ * Clients that allocate more data in a transaction than the default
+ * fill would have to commit early when their allocator runs low, so we
+ * give them enough to cover two of their transactions, up to a limit.
+ * The lo threshold grows with the target so that they're refilled
+ * before they'd run low during their next transaction.
+ */
+#define DATA_FILL_MAX_MULT 4
+
+static void client_data_fill(struct super_block *sb, struct server_client_info *sci,
+			     u64 *lo, u64 *target)
+{
+	u64 want = sci ? sci->data_consumed * 2 : 0;
+
+	if (want <= SCOUTFS_SERVER_DATA_FILL_TARGET) {
+		*lo = SCOUTFS_SERVER_DATA_FILL_LO;
+		*target = SCOUTFS_SERVER_DATA_FILL_TARGET;
+		return;
+	}
+
+	scoutfs_inc_counter(sb, server_data_fill_boosted);
+	*target = min_t(u64, want, SCOUTFS_SERVER_DATA_FILL_TARGET * DATA_FILL_MAX_MULT);
+	*lo = max_t(u64, SCOUTFS_SERVER_DATA_FILL_LO, *target / 2);
+}
+
+/*
+ * Record the allocator blocks that a client consumed during the
+ * transaction it's committing.  The existing item has the allocators
+ * as we gave them to the client and the committing item has what's
+ * left.
+ */
+static void record_client_consumption(struct super_block *sb, struct server_client_info *sci,
+				      struct scoutfs_log_trees *exist,
+				      struct scoutfs_log_trees *lt)
+{
+	u64 given;
+	u64 left;
+	u64 meta;
+	u64 data;
+
+	given = le64_to_cpu(exist->meta_avail.total_len);
+	left = le64_to_cpu(lt->meta_avail.total_len);
+	meta = given > left ? given - left : 0;
+
+	given = le64_to_cpu(exist->data_avail.total_len);
+	left = le64_to_cpu(lt->data_avail.total_len);
+	data = given > left ? given - left : 0;
+
+	scoutfs_add_counter(sb, server_client_meta_consumed, meta);
+	scoutfs_add_counter(sb, server_client_data_consumed, data);
+
+	if (sci) {
+		sci->meta_consumed = ((sci->meta_consumed * 3) + meta) / 4;
+		sci->data_consumed = ((sci->data_consumed * 3) + data) / 4;
+	}
+}
+
 static int alloc_move_empty(struct super_block *sb,
 			    struct scoutfs_alloc_root *dst,
 			    struct scoutfs_alloc_root *src, u64 meta_budget)
@@ -1368,6 +1466,8 @@ static int server_get_log_trees(struct super_block *sb,
 	COMMIT_HOLD(hold);
 	u64 data_zone_blocks;
 	char *err_str = NULL;
+	u64 data_lo;
+	u64 data_target;
 	u64 nr;
 	int ret;
 	int err;
@@ -1476,9 +1576,9 @@ static int server_get_log_trees(struct super_block *sb,
 	else
 		lt.meta_avail.flags &= ~cpu_to_le32(SCOUTFS_ALLOC_FLAG_LOW);
 
+	client_data_fill(sb, conn->info, &data_lo, &data_target);
 	ret = alloc_move_refill_zoned(sb, &lt.data_avail, &super->data_alloc,
-				      SCOUTFS_SERVER_DATA_FILL_LO, SCOUTFS_SERVER_DATA_FILL_TARGET,
-				      exclusive, vacant, data_zone_blocks);
+				      data_lo, data_target, exclusive, vacant, data_zone_blocks);
 	if (ret < 0) {
 		err_str = "refilling data_avail";
 		goto update;
@@ -1596,6 +1696,8 @@ static int server_commit_log_trees(struct super_block *sb,
 			} else {
 				if (exist->commit_trans_seq == lt.get_trans_seq)
 					committed = true;
+				else
+					record_client_consumption(sb, conn->info, exist, &lt);
 			}
 		} else {
 			ret = -EIO;
@@ -1871,6 +1973,21 @@ static int server_lock(struct super_block *sb,
 	return scoutfs_lock_server_request(sb, rid, id, arg);
 }
 
+static int server_lock_batch(struct super_block *sb,
+			     struct scoutfs_net_connection *conn,
+			     u8 cmd, u64 id, void *arg, u16 arg_len)
+{
+	struct scoutfs_net_lock_batch *nlb = arg;
+	u64 rid = scoutfs_net_client_rid(conn);
+
+	if (arg_len < sizeof(struct scoutfs_net_lock_batch) ||
+	    arg_len != offsetof(struct scoutfs_net_lock_batch,
+				locks[le16_to_cpu(nlb->nr)]))
+		return -EINVAL;
+
+	return scoutfs_lock_server_request_batch(sb, rid, id, nlb);
+}
+
 static int lock_response(struct super_block *sb,
 			 struct scoutfs_net_connection *conn,
 			 void *resp, unsigned int resp_len,
@@ -1905,6 +2022,17 @@ int scoutfs_server_lock_response(struct super_block *sb, u64 rid, u64 id,
 					 nl, sizeof(*nl));
 }
 
+int scoutfs_server_lock_batch_response(struct super_block *sb, u64 rid, u64 id,
+				       struct scoutfs_net_lock_batch *nlb)
+{
+	struct server_info *server = SCOUTFS_SB(sb)->server_info;
+
+	return scoutfs_net_response_node(sb, server->conn, rid,
+					 SCOUTFS_NET_CMD_LOCK_BATCH, id, 0, nlb,
+					 offsetof(struct scoutfs_net_lock_batch,
+						  locks[le16_to_cpu(nlb->nr)]));
+}
+
 static bool invalid_recover(struct scoutfs_net_lock_recover *nlr,
 			    unsigned long bytes)
 {
@@ -3697,7 +3825,7 @@ send_err:
 	greet.fmt_vers = cpu_to_le64(sbi->fmt_vers);
 	greet.server_term = cpu_to_le64(server->term);
 	greet.rid = gr->rid;
-	greet.flags = 0;
+	greet.flags = cpu_to_le64(SCOUTFS_NET_GREETING_FLAG_LOCK_BATCH);
 
 	/* queue greeting response to be sent first once messaging enabled */
 	ret = scoutfs_net_response(sb, conn, cmd, id, err,
@@ -4023,6 +4151,7 @@ static scoutfs_net_request_t server_req_funcs[] = {
 	[SCOUTFS_NET_CMD_RESIZE_DEVICES]	= server_resize_devices,
 	[SCOUTFS_NET_CMD_STATFS]		= server_statfs,
 	[SCOUTFS_NET_CMD_FAREWELL]		= server_farewell,
+	[SCOUTFS_NET_CMD_LOCK_BATCH]		= server_lock_batch,
 };
 
 static void server_notify_up(struct super_block *sb,
@@ -62,6 +62,8 @@ int scoutfs_server_lock_request(struct super_block *sb, u64 rid,
 				struct scoutfs_net_lock *nl);
 int scoutfs_server_lock_response(struct super_block *sb, u64 rid, u64 id,
 				 struct scoutfs_net_lock *nl);
+int scoutfs_server_lock_batch_response(struct super_block *sb, u64 rid, u64 id,
+				       struct scoutfs_net_lock_batch *nlb);
 int scoutfs_server_lock_recover_request(struct super_block *sb, u64 rid,
 					struct scoutfs_key *key);
 void scoutfs_server_recov_finish(struct super_block *sb, u64 rid, int which);
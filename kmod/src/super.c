@@ -139,6 +139,10 @@ static int scoutfs_sync_fs(struct super_block *sb, int wait)
 	trace_scoutfs_sync_fs(sb, wait);
 	scoutfs_inc_counter(sb, trans_commit_sync_fs);
 
+	/* include items removed by deletion of previously unlinked inodes */
+	if (wait)
+		scoutfs_inode_flush_deletes(sb);
+
 	return scoutfs_trans_sync(sb, wait);
 }
 
@@ -505,6 +509,7 @@ static int scoutfs_fill_super(struct super_block *sb, void *data, int silent)
 	spin_lock_init(&sbi->next_ino_lock);
 	spin_lock_init(&sbi->data_wait_root.lock);
 	sbi->data_wait_root.root = RB_ROOT;
+	INIT_LIST_HEAD(&sbi->data_wait_root.listeners);
 
 	/* parse options early for use during setup */
 	ret = scoutfs_options_early_setup(sb, data);
@@ -632,6 +637,7 @@ MODULE_ALIAS_FS("scoutfs");
 static void teardown_module(void)
 {
 	debugfs_remove(scoutfs_debugfs_root);
+	scoutfs_net_exit();
 	scoutfs_inode_exit();
 	scoutfs_sysfs_exit();
 }
@@ -669,6 +675,7 @@ static int __init scoutfs_module_init(void)
 		goto out;
 	}
 	ret = scoutfs_inode_init() ?:
+	      scoutfs_net_init() ?:
 	      register_filesystem(&scoutfs_fs_type);
 out:
 	if (ret)
@@ -0,0 +1,158 @@
+/*
+ * Measure the rate at which concurrent processes can acquire cached
+ * inode locks.  Each process repeatedly stats all the entries in its
+ * own directory so that every stat is a lock call that matches an
+ * already granted read lock.
+ *
+ * Copyright (C) 2026 Versity Software, Inc.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License v2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <time.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+
+static void exit_usage(void)
+{
+	printf(" -h/-?         output this usage message and exit\n"
+	       " -s <seconds>  number of seconds to run, default 5\n"
+	       " dir ...       one process stats each directory's entries\n");
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static unsigned long long stat_dir(char *path, unsigned int secs)
+{
+	unsigned long long ops = 0;
+	struct dirent *dent;
+	struct stat st;
+	double stop;
+	DIR *dir;
+	int fd;
+
+	dir = opendir(path);
+	if (!dir) {
+		fprintf(stderr, "error opening dir '%s': %s (%d)\n",
+			path, strerror(errno), errno);
+		exit(1);
+	}
+	fd = dirfd(dir);
+
+	stop = now() + secs;
+	do {
+		rewinddir(dir);
+		while ((dent = readdir(dir))) {
+			if (fstatat(fd, dent->d_name, &st, AT_SYMLINK_NOFOLLOW) < 0) {
+				fprintf(stderr, "error stating '%s/%s': %s (%d)\n",
+					path, dent->d_name, strerror(errno), errno);
+				exit(1);
+			}
+			ops++;
+		}
+	} while (now() < stop);
+
+	closedir(dir);
+	return ops;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long long *results;
+	unsigned long long total = 0;
+	unsigned int secs = 5;
+	double start;
+	double elapsed;
+	pid_t pid;
+	int status;
+	int nr;
+	int i;
+	int c;
+
+	while ((c = getopt(argc, argv, "+s:")) != -1) {
+
+		switch (c) {
+			case 's':
+				secs = strtoul(optarg, NULL, 0);
+				break;
+			case '?':
+				printf("unknown argument: %c\n", optind);
+			case 'h':
+				exit_usage();
+		}
+	}
+
+	nr = argc - optind;
+	if (nr <= 0 || secs == 0) {
+		printf("specify at least one directory and non-zero seconds\n");
+		exit_usage();
+	}
+
+	results = mmap(NULL, nr * sizeof(results[0]), PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (results == MAP_FAILED) {
+		fprintf(stderr, "error mapping results: %s (%d)\n",
+			strerror(errno), errno);
+		exit(1);
+	}
+
+	start = now();
+
+	for (i = 0; i < nr; i++) {
+		pid = fork();
+		if (pid < 0) {
+			fprintf(stderr, "fork error: %s (%d)\n",
+				strerror(errno), errno);
+			exit(1);
+		}
+		if (pid == 0) {
+			results[i] = stat_dir(argv[optind + i], secs);
+			exit(0);
+		}
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (wait(&status) < 0 || !WIFEXITED(status) ||
+		    WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "child process failed\n");
+			exit(1);
+		}
+	}
+
+	elapsed = now() - start;
+
+	for (i = 0; i < nr; i++)
+		total += results[i];
+
+	printf("procs %d ops %llu secs %.3f ops_per_sec %.0f\n",
+	       nr, total, elapsed, (double)total / elapsed);
+
+	return 0;
+}
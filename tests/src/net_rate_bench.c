@@ -0,0 +1,149 @@
+/*
+ * Measure the rate at which concurrent processes can exchange small
+ * request and response messages between a mount's client and the
+ * server.  Each statfs call on a scoutfs mount is a round trip of a
+ * statfs request to the server over its loopback connection.
+ *
+ * Copyright (C) 2026 Versity Software, Inc.  All rights reserved.
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public
+ * License v2 as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/types.h>
+#include <sys/statfs.h>
+#include <sys/wait.h>
+#include <sys/mman.h>
+
+static void exit_usage(void)
+{
+	printf(" -h/-?         output this usage message and exit\n"
+	       " -p <procs>    number of concurrent processes, default 1\n"
+	       " -s <seconds>  number of seconds to run, default 5\n"
+	       " path          path in the scoutfs mount to statfs\n");
+	exit(1);
+}
+
+static double now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ((double)ts.tv_nsec / 1000000000.0);
+}
+
+static unsigned long long statfs_path(char *path, unsigned int secs)
+{
+	unsigned long long ops = 0;
+	struct statfs sfs;
+	double stop;
+	int i;
+
+	stop = now() + secs;
+	do {
+		/* don't read the clock for every tiny round trip */
+		for (i = 0; i < 64; i++) {
+			if (statfs(path, &sfs) < 0) {
+				fprintf(stderr, "error statfs '%s': %s (%d)\n",
+					path, strerror(errno), errno);
+				exit(1);
+			}
+			ops++;
+		}
+	} while (now() < stop);
+
+	return ops;
+}
+
+int main(int argc, char **argv)
+{
+	unsigned long long *results;
+	unsigned long long total = 0;
+	unsigned int secs = 5;
+	unsigned int nr = 1;
+	double start;
+	double elapsed;
+	char *path;
+	pid_t pid;
+	int status;
+	int i;
+	int c;
+
+	while ((c = getopt(argc, argv, "+p:s:")) != -1) {
+
+		switch (c) {
+			case 'p':
+				nr = strtoul(optarg, NULL, 0);
+				break;
+			case 's':
+				secs = strtoul(optarg, NULL, 0);
+				break;
+			case '?':
+				printf("unknown argument: %c\n", optind);
+			case 'h':
+				exit_usage();
+		}
+	}
+
+	if (optind != argc - 1 || nr == 0 || secs == 0) {
+		printf("specify one path and non-zero procs and seconds\n");
+		exit_usage();
+	}
+	path = argv[optind];
+
+	results = mmap(NULL, nr * sizeof(results[0]), PROT_READ | PROT_WRITE,
+		       MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+	if (results == MAP_FAILED) {
+		fprintf(stderr, "error mapping results: %s (%d)\n",
+			strerror(errno), errno);
+		exit(1);
+	}
+
+	start = now();
+
+	for (i = 0; i < nr; i++) {
+		pid = fork();
+		if (pid < 0) {
+			fprintf(stderr, "fork error: %s (%d)\n",
+				strerror(errno), errno);
+			exit(1);
+		}
+		if (pid == 0) {
+			results[i] = statfs_path(path, secs);
+			exit(0);
+		}
+	}
+
+	for (i = 0; i < nr; i++) {
+		if (wait(&status) < 0 || !WIFEXITED(status) ||
+		    WEXITSTATUS(status) != 0) {
+			fprintf(stderr, "child process failed\n");
+			exit(1);
+		}
+	}
+
+	elapsed = now() - start;
+
+	for (i = 0; i < nr; i++)
+		total += results[i];
+
+	printf("procs %u round_trips %llu secs %.3f round_trips_per_sec %.0f\n",
+	       nr, total, elapsed, (double)total / elapsed);
+
+	return 0;
+}
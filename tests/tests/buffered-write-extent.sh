@@ -0,0 +1,25 @@
+#
+# Test that a single buffered write of many blocks allocates one extent
+# for the whole write rather than growing its allocation as each page
+# is dirtied.
+#
+
+t_require_commands dd filefrag
+
+FILE="$T_D0/file"
+
+echo "== single multi-block write allocates one extent"
+nr=$(t_counter data_alloc_write_extent 0)
+dd if=/dev/zero of="$FILE" bs=1M count=1 status=none
+t_counter_diff_changed data_alloc_write_extent $nr 0
+filefrag "$FILE" | t_filter_fs
+
+echo "== appending write allocates from the end of the file"
+nr=$(t_counter data_alloc_write_extent 0)
+dd if=/dev/zero of="$FILE" bs=1M count=1 oflag=append conv=notrunc status=none
+t_counter_diff_changed data_alloc_write_extent $nr 0
+stat -c "%s" "$FILE"
+
+rm -f "$FILE"
+
+t_pass
@@ -0,0 +1,51 @@
+#
+# Stream a large file through buffered and direct IO.  The rates are
+# only logged, the output shows that direct IO was used and that both
+# paths read and write the same contents.
+#
+
+t_require_commands dd cmp
+
+# kernels with the old aio methods don't get a direct_IO method
+touch "$T_D0/probe"
+dd if=/dev/zero of="$T_D0/probe" bs=4096 count=1 oflag=direct status=none \
+	2>/dev/null || t_skip "direct IO not supported"
+rm -f "$T_D0/probe"
+
+SRC="$T_TMP.src"
+MB=256
+
+dd if=/dev/urandom of="$SRC" bs=1M count=$MB status=none
+
+echo "== buffered streaming write and read"
+echo "buffered write:" >> $T_TMP.log
+dd if="$SRC" of="$T_D0/buffered" bs=8M conv=fsync 2>> $T_TMP.log
+echo 3 > /proc/sys/vm/drop_caches
+echo "buffered read:" >> $T_TMP.log
+dd if="$T_D0/buffered" of=/dev/null bs=8M 2>> $T_TMP.log
+
+echo "== direct streaming write and read"
+old=$(t_counter data_direct_write)
+echo "direct write:" >> $T_TMP.log
+dd if="$SRC" of="$T_D0/direct" bs=8M oflag=direct conv=fsync 2>> $T_TMP.log
+t_counter_diff_changed data_direct_write $old
+echo 3 > /proc/sys/vm/drop_caches
+old=$(t_counter data_direct_read)
+echo "direct read:" >> $T_TMP.log
+dd if="$T_D0/direct" of=/dev/null bs=8M iflag=direct 2>> $T_TMP.log
+t_counter_diff_changed data_direct_read $old
+
+echo "== direct and buffered contents match"
+cmp "$SRC" "$T_D0/buffered"
+cmp "$SRC" "$T_D0/direct"
+dd if="$T_D0/buffered" bs=8M iflag=direct status=none | cmp - "$SRC"
+
+echo "== direct overwrite is seen by buffered reads"
+dd if=/dev/urandom of="$SRC" bs=1M count=16 seek=8 conv=notrunc status=none
+dd if="$SRC" of="$T_D0/buffered" bs=1M count=16 skip=8 seek=8 \
+	oflag=direct conv=notrunc status=none
+cmp "$SRC" "$T_D0/buffered"
+
+rm -f "$SRC" "$T_D0/buffered" "$T_D0/direct"
+
+t_pass
@@ -1,8 +1,8 @@
 #
 # test that the data prealloc options behave as expected.  We write to
 # two files a block at a time so that a single file doesn't naturally
-# merge adjacent consecutive allocations.  (we don't have multiple
-# allocation cursors)
+# merge adjacent consecutive allocations.  (allocation streams only
+# keep files contiguous once they've written far more than these files)
 #
 t_require_commands scoutfs stat filefrag dd touch truncate
 
@@ -0,0 +1,51 @@
+#
+# Test that large files written concurrently on one mount are each
+# allocated contiguous regions of the device rather than interleaving
+# their allocations.
+#
+
+t_require_commands dd filefrag awk
+
+MB=256
+# without streams writers would interleave every prealloc region
+MAX_RUNS=8
+
+#
+# Count the physically contiguous runs of the file's extents.
+#
+physical_runs()
+{
+	filefrag -v -b4096 "$1" | awk '
+		($1 ~ /^[0-9]+:$/) {
+			start = $4; sub(/\.\./, "", start);
+			end = $5; sub(/:/, "", end);
+			if (runs == 0 || start != prev + 1)
+				runs++;
+			prev = end;
+		}
+		END { print runs + 0 }
+	'
+}
+
+echo "== concurrent streaming writes"
+cursor=$(t_counter data_stream_alloc_cursor 0)
+new=$(t_counter data_stream_alloc_new 0)
+resv=$(t_counter data_stream_alloc_resv 0)
+dd if=/dev/zero of="$T_D0/file-a" bs=1M count=$MB conv=fsync status=none &
+dd if=/dev/zero of="$T_D0/file-b" bs=1M count=$MB conv=fsync status=none &
+wait
+t_counter_diff_changed data_stream_alloc_cursor $cursor 0
+t_counter_diff_changed data_stream_alloc_new $new 0
+t_counter_diff_changed data_stream_alloc_resv $resv 0
+
+echo "== each file is contiguous"
+for f in file-a file-b; do
+	runs=$(physical_runs "$T_D0/$f")
+	echo "$f runs $runs" >> $T_TMP.log
+	test "$runs" -ge 1 -a "$runs" -le $MAX_RUNS || \
+		t_fail "$f has $runs physical runs, more than $MAX_RUNS"
+done
+
+rm -f "$T_D0/file-a" "$T_D0/file-b"
+
+t_pass
@@ -0,0 +1,52 @@
+#
+# Test that cached dentries are revalidated by checking their dirents
+# after other mounts modify their directories.
+#
+
+t_require_commands stat touch mv
+t_require_mounts 2
+
+NR=50
+
+stat_inos()
+{
+	local i
+
+	for i in $(seq 1 $NR); do
+		stat -c '%i' "$1/file-$i"
+	done
+}
+
+echo "== create and cache entries"
+mkdir -p "$T_D0/dir"
+for i in $(seq 1 $NR); do
+	touch "$T_D0/dir/file-$i"
+done
+stat_inos "$T_D0/dir" > "$T_TMP.inos"
+
+echo "== unrelated remote changes keep cached dentries"
+touch "$T_D1/dir/other"
+dirent=$(t_counter dentry_revalidate_dirent 0)
+invalid=$(t_counter dentry_revalidate_invalid 0)
+stat_inos "$T_D0/dir" | diff -u "$T_TMP.inos" -
+t_counter_diff_changed dentry_revalidate_dirent $dirent 0
+t_counter_diff dentry_revalidate_invalid $invalid 0
+
+echo "== remote removal is seen"
+rm "$T_D1/dir/file-1"
+stat "$T_D0/dir/file-1" 2>&1 | t_filter_fs
+
+echo "== remote rename over cached name is seen"
+mv "$T_D1/dir/other" "$T_D1/dir/file-2"
+test "$(stat -c '%i' "$T_D0/dir/file-2")" == "$(stat -c '%i' "$T_D1/dir/file-2")" || \
+	t_fail "renamed entry inode didn't match"
+
+echo "== remote creation over cached negative dentry is seen"
+stat "$T_D0/dir/file-1" > /dev/null 2>&1
+touch "$T_D1/dir/file-1"
+test "$(stat -c '%i' "$T_D0/dir/file-1")" == "$(stat -c '%i' "$T_D1/dir/file-1")" || \
+	t_fail "created entry inode didn't match"
+
+rm -rf "$T_D0/dir"
+
+t_pass
@@ -0,0 +1,78 @@
+#
+# Test that directories build an index of their entries after enough
+# lookups and that the index stays consistent with local and remote
+# entry changes.
+#
+
+t_require_commands createmany stat touch mv
+t_require_mounts 2
+
+NR=1000
+
+drop_dentries()
+{
+	echo 2 > /proc/sys/vm/drop_caches
+}
+
+stat_names()
+{
+	local n
+
+	for n in "$@"; do
+		stat -c '%n' "$T_D0/dir/$n" 2>&1 | t_filter_fs
+	done
+}
+
+echo "== index is disabled by default"
+t_get_sysfs_mount_option 0 dir_index_lookups
+echo
+
+echo "== lookups build and use the index"
+mkdir -p "$T_D0/dir"
+createmany -o "$T_D0/dir/file-" $NR >> $T_TMP.log
+# keep the dir inode, and its index, cached as dentries are dropped
+exec 5< "$T_D0/dir"
+t_set_sysfs_mount_option 0 dir_index_lookups 10
+build=$(t_counter dir_index_build 0)
+hit=$(t_counter dir_index_hit 0)
+drop_dentries
+ls -l "$T_D0/dir" > /dev/null
+t_counter_diff_changed dir_index_build $build 0
+t_counter_diff_changed dir_index_hit $hit 0
+
+echo "== local entry changes are seen by indexed lookups"
+rm "$T_D0/dir/file-1"
+mv "$T_D0/dir/file-2" "$T_D0/dir/renamed"
+touch "$T_D0/dir/created"
+hit=$(t_counter dir_index_hit 0)
+drop_dentries
+stat_names file-1 file-2 renamed created
+t_counter_diff_changed dir_index_hit $hit 0
+
+echo "== remote changes are seen after rebuilding the index"
+drop=$(t_counter dir_index_drop 0)
+touch "$T_D1/dir/remote"
+rm "$T_D1/dir/created"
+# invalidating the dir's lock frees its index
+t_counter_diff_changed dir_index_drop $drop 0
+build=$(t_counter dir_index_build 0)
+drop_dentries
+ls -l "$T_D0/dir" > /dev/null
+t_counter_diff_changed dir_index_build $build 0
+stat_names created remote
+test "$(stat -c '%i' "$T_D0/dir/remote")" == "$(stat -c '%i' "$T_D1/dir/remote")" || \
+	t_fail "remote entry inode didn't match"
+
+echo "== index can be disabled"
+t_set_sysfs_mount_option 0 dir_index_lookups 0
+t_get_sysfs_mount_option 0 dir_index_lookups
+echo
+hit=$(t_counter dir_index_hit 0)
+drop_dentries
+ls -l "$T_D0/dir" > /dev/null
+t_counter_diff dir_index_hit $hit 0
+
+exec 5<&-
+rm -rf "$T_D0/dir"
+
+t_pass
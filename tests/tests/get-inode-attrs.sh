@@ -0,0 +1,61 @@
+#
+# Test the _GET_INODE_ATTRS ioctl via the get-inode-attrs cli command
+# by comparing its attributes with stat.
+#
+
+t_require_commands scoutfs stat touch
+
+NR=100
+GIA="scoutfs get-inode-attrs -p $T_M0"
+
+# print the fields that stat can also print
+gia_fields()
+{
+	$GIA "$@" | \
+	while read -r _ ino _ mode _ nlink _ uid _ gid _ size _ mtime _; do
+		printf "%s %x %s %s %s %s %s\n" \
+			"$ino" "$mode" "$nlink" "$uid" "$gid" "$size" "${mtime%.*}"
+	done
+}
+
+stat_fields()
+{
+	(cd "$T_D0/dir" && ls -A | xargs -r stat -c '%i %f %h %u %g %s %Y') | sort -n
+}
+
+echo "== create files"
+mkdir "$T_D0/dir"
+for i in $(seq 1 $NR); do
+	dd if=/dev/zero of="$T_D0/dir/file-$i" bs=1 count=$i status=none
+done
+mkdir "$T_D0/dir/subdir"
+ln -s file-1 "$T_D0/dir/symlink"
+chown 1234:5678 "$T_D0/dir/file-1"
+sync
+first=$(stat_fields | head -1 | cut -d ' ' -f 1)
+last=$(stat_fields | tail -1 | cut -d ' ' -f 1)
+
+echo "== attributes match stat"
+diff -u <(stat_fields) <(gia_fields -f $first -l $last | \
+	awk 'NR == FNR { want[$1]; next } $1 in want' <(stat_fields) -)
+
+echo "== range is limited"
+test "$(gia_fields -f $first -l $first | wc -l)" == 1 || \
+	t_fail "first inode range didn't return one inode"
+test "$(gia_fields -f $((last + 1)) -l $last | wc -l)" == 0 || \
+	t_fail "inverted range returned inodes"
+
+echo "== seq finds modified inodes"
+seq=$(scoutfs statfs -s committed_seq -p "$T_M0")
+touch "$T_D0/dir/file-10"
+sync
+diff -u <(stat -c '%i' "$T_D0/dir/file-10") \
+	<(gia_fields -f $first -l $last -m $((seq + 1)) | cut -d ' ' -f 1)
+
+echo "== deleted inodes aren't returned"
+rm -rf "$T_D0/dir"
+sync
+test "$(gia_fields -f $first -l $last | wc -l)" == 0 || \
+	t_fail "deleted inodes were returned"
+
+t_pass
@@ -82,6 +82,20 @@ touch "$T_D0/dir"/files-{1..5}
 rm -f "$T_D0/dir"/files-*
 rmdir "$T_D0/dir"
 
+echo "== unlinked inodes are deleted in the background"
+mkdir "$T_D0/dir"
+touch "$T_D0/dir"/files-{1..100}
+sync
+deferred=$(t_counter inode_delete_deferred 0)
+deleted=$(t_counter inode_deleted 0)
+rm -f "$T_D0/dir"/files-*
+rmdir "$T_D0/dir"
+sync
+test "$(t_counter_diff_value inode_delete_deferred $deferred 0)" -ge 100 || \
+	t_fail "unlinked inodes weren't queued for deletion"
+test "$(t_counter_diff_value inode_deleted $deleted 0)" -ge 100 || \
+	t_fail "queued inodes weren't deleted after sync"
+
 echo "== open files survive remote scanning orphans"
 echo "contents" > "$T_D0/file"
 ino=$(stat -c "%i" "$T_D0/file")
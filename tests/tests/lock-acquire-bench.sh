@@ -0,0 +1,39 @@
+#
+# Measure the rate of concurrent lock acquisition that matches granted
+# locks.  Each process stats files in its own directory whose inodes
+# span many lock groups.  The rates are only logged, the output just
+# shows that the lock fast path was used.
+#
+
+t_require_commands createmany lock_acquire_bench
+
+DIRS="0 1 2 3 4 5 6 7"
+COUNT=2048
+SECS=5
+# background work like orphan scans and commits can request a few locks
+MAX_GRANT_REQUESTS=16
+
+echo "== create files"
+for i in $DIRS; do
+	mkdir -p "$T_D0/$i"
+	createmany -o "$T_D0/$i/file_$i" $COUNT >> $T_TMP.log &
+done
+wait
+
+echo "== single process"
+lock_acquire_bench -s $SECS "$T_D0/0" >> $T_TMP.log
+
+echo "== parallel processes"
+old=$(t_counter lock_grant_request)
+paths=$(for i in $DIRS; do echo "$T_D0/$i"; done)
+lock_acquire_bench -s $SECS $paths >> $T_TMP.log
+nr=$(t_counter_diff_value lock_grant_request $old 0)
+echo "lock_grant_request diff $nr" >> $T_TMP.log
+test "$nr" -le $MAX_GRANT_REQUESTS || \
+	t_fail "benchmark requested $nr lock grants, more than $MAX_GRANT_REQUESTS"
+
+for i in $DIRS; do
+	rm -rf "$T_D0/$i"
+done
+
+t_pass
@@ -0,0 +1,40 @@
+#
+# Test that mounts hold granted write locks for the minimum hold time
+# while other mounts are contending for them.
+#
+
+t_require_commands createmany
+t_require_mounts 2
+
+COUNT=2000
+
+echo "== holding is disabled by default"
+t_get_sysfs_mount_option 0 lock_min_hold_ms
+echo
+
+echo "== contending creates hold write locks"
+mkdir -p "$T_D0/dir"
+old0=$(t_counter lock_invalidate_held 0)
+old1=$(t_counter lock_invalidate_held 1)
+t_set_sysfs_mount_option 0 lock_min_hold_ms 50
+t_set_sysfs_mount_option 1 lock_min_hold_ms 50
+createmany -o "$T_D0/dir/zero_" $COUNT >> $T_TMP.log &
+createmany -o "$T_D1/dir/one_" $COUNT >> $T_TMP.log &
+wait
+held=$(( $(t_counter lock_invalidate_held 0) - old0 +
+	 $(t_counter lock_invalidate_held 1) - old1 ))
+test "$held" -gt 0 || t_fail "no write locks were held"
+
+echo "== all entries were created"
+ls "$T_D0/dir" | wc -l
+ls "$T_D1/dir" | wc -l
+
+echo "== holding can be disabled"
+t_set_sysfs_mount_option 0 lock_min_hold_ms 0
+t_set_sysfs_mount_option 1 lock_min_hold_ms 0
+t_get_sysfs_mount_option 1 lock_min_hold_ms
+echo
+
+rm -rf "$T_D0/dir"
+
+t_pass
@@ -0,0 +1,55 @@
+#
+# Test that read locks on sequential inode groups are prefetched with
+# batched lock requests that the server only grants when they don't
+# conflict with other mounts.
+#
+
+t_require_commands createmany stat
+t_require_mounts 2
+
+COUNT=5000
+
+#
+# Run the command on all the files in inode order from the given mount.
+#
+each_file()
+{
+	local nr="$1"
+	local cmd="$2"
+	local dir="$(eval echo \$T_D$nr)/dir"
+
+	ls "$dir" | sort -V | sed "s@^@$dir/@" | xargs $cmd > /dev/null
+}
+
+echo "== create files"
+mkdir -p "$T_D0/dir"
+createmany -o "$T_D0/dir/file_" $COUNT >> $T_TMP.log
+sync
+
+echo "== conflicting prefetch isn't granted"
+t_umount 1
+t_mount_opt 1 "lock_prefetch=1"
+# write locks on mount 0 conflict with every prefetched read lock
+each_file 0 touch
+old=$(t_counter lock_batch_granted 1)
+each_file 1 stat
+t_counter_diff lock_batch_granted $old 1
+
+echo "== compatible prefetch is granted"
+# reading every inode without prefetch downgrades mount 0's write locks
+t_set_sysfs_mount_option 1 lock_prefetch 0
+each_file 1 stat
+t_umount 1
+t_mount_opt 1 "lock_prefetch=1"
+old=$(t_counter lock_batch_granted 1)
+each_file 1 stat
+t_counter_diff_changed lock_batch_granted $old 1
+
+echo "== prefetch option can be disabled"
+t_set_sysfs_mount_option 1 lock_prefetch 0
+t_get_sysfs_mount_option 1 lock_prefetch
+echo
+
+rm -rf "$T_D0/dir"
+
+t_pass
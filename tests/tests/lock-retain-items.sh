@@ -0,0 +1,34 @@
+#
+# Test that a mount keeps its cached items when its read lock is
+# invalidated by a writer on another mount that doesn't modify any
+# items, and drops them when the writer did modify items.
+#
+
+t_require_commands createmany stat scoutfs
+t_require_mounts 2
+
+COUNT=100
+
+echo "== create files and read them on another mount"
+mkdir -p "$T_D0/dir"
+createmany -o "$T_D0/dir/file_" $COUNT >> $T_TMP.log
+sync
+stat "$T_D1/dir/"* > /dev/null
+
+echo "== unmodified write keeps reader's items"
+old=$(t_counter lock_retain_items_kept 1)
+# a release with the wrong data version write locks but doesn't modify
+scoutfs release "$T_D0/dir/file_1" -V 12345 -o 0 -l 4096 2> /dev/null && \
+	echo "release with wrong data version succeeded"
+stat "$T_D1/dir/"* > /dev/null
+t_counter_diff_changed lock_retain_items_kept $old 1
+
+echo "== modified write drops reader's items"
+old=$(t_counter lock_retain_items_dropped 1)
+touch "$T_D0/dir/file_1"
+stat "$T_D1/dir/"* > /dev/null
+t_counter_diff_changed lock_retain_items_dropped $old 1
+
+rm -rf "$T_D0/dir"
+
+t_pass
@@ -0,0 +1,26 @@
+#
+# Each mount records latency histograms for the requests it sends and
+# the requests it processes.  statfs requests are sent by every mount
+# and processed by the server.
+#
+
+t_require_commands scoutfs stat
+
+sv=$(t_server_nr)
+
+echo "== send statfs requests"
+for i in $(seq 1 100); do
+	stat -f "$T_D0" > /dev/null
+done
+
+echo "== statfs request latency recorded by client"
+scoutfs counters -l "$(t_sysfs_path 0)" > $T_TMP.lat
+cat $T_TMP.lat >> $T_TMP.log
+awk '($1 == "request" && $2 == "statfs" && $3 >= 100) {print $1, $2}' $T_TMP.lat
+
+echo "== statfs process latency recorded by server"
+scoutfs counters -l "$(t_sysfs_path $sv)" > $T_TMP.lat
+cat $T_TMP.lat >> $T_TMP.log
+awk '($1 == "process" && $2 == "statfs" && $3 >= 100) {print $1, $2}' $T_TMP.lat
+
+t_pass
@@ -0,0 +1,25 @@
+#
+# The server processes received messages in workqueues by the priority
+# class of their command.  Make sure that lock and commit traffic from
+# the mounts is reported in the server's proc queue stats.
+#
+
+t_require_commands createmany
+
+sv=$(t_server_nr)
+queues="$(t_sysfs_path $sv)/net/proc_queues"
+
+echo "== create and sync to send lock and commit requests"
+mkdir -p "$T_D0/dir"
+createmany -o "$T_D0/dir/file_" 1000 >> $T_TMP.log
+sync
+
+echo "== lock and commit requests were processed in their classes"
+cat "$queues" >> $T_TMP.log
+for cmd in lock commit_log_trees; do
+	grep "^$cmd " "$queues" | awk '{print $1, $2, $3, ($7 > 0) ? "processed" : "unprocessed"}'
+done
+
+rm -rf "$T_D0/dir"
+
+t_pass
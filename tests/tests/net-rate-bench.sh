@@ -0,0 +1,27 @@
+#
+# Measure the rate of small request and response round trips between
+# mounts' clients and the server.  statfs sends a request to the
+# server for every call.  The rates are only logged, the output just
+# shows that the calls were sent as messages.
+#
+
+t_require_commands net_rate_bench
+
+SECS=5
+
+echo "== single process"
+old=$(t_counter net_recv_messages)
+net_rate_bench -s $SECS "$T_D0" >> $T_TMP.log
+t_counter_diff_changed net_recv_messages $old
+
+echo "== parallel processes"
+net_rate_bench -s $SECS -p 8 "$T_D0" >> $T_TMP.log
+
+echo "== parallel processes on all mounts"
+for i in $(t_fs_nrs); do
+	eval path="\$T_D${i}"
+	net_rate_bench -s $SECS -p 4 "$path" >> $T_TMP.log &
+done
+wait
+
+t_pass
@@ -28,6 +28,19 @@ expect_wait()
 	diff -u $T_TMP.wait.expected $T_TMP.wait.output
 }
 
+#
+# Wait until a task is waiting for offline data, the caller knows that
+# one is about to block.
+#
+wait_for_waiter()
+{
+	local file=$1
+
+	while test -z "$(scoutfs data-waiting -B 0 -I 0 -p "$file")"; do
+		sleep .1
+	done
+}
+
 t_quiet mkdir -p "$DIR"
 
 echo "== create files"
@@ -174,6 +187,26 @@ expect_wait "$DIR/file" "write" $ino 0
 scoutfs stage "$DIR/golden" "$DIR/file" -V "$vers" -o 0 -l $BYTES
 cmp "$DIR/file" "$DIR/other"
 
+echo "== following prints waiters as they arrive"
+vers=$(scoutfs stat -s data_version "$DIR/file")
+scoutfs data-waiting -f -B 0 -I 0 -p "$DIR" > $T_TMP.follow &
+pid="$!"
+scoutfs release "$DIR/file" -V "$vers" -o 0 -l $BYTES
+dd if="$DIR/file" of=/dev/null status=none bs=$BS count=1 skip=3 2> /dev/null &
+dd_pid="$!"
+wait_for_waiter "$DIR/file"
+# follow prints existing waiters as it starts, it can see ours twice
+while ! test -s $T_TMP.follow; do
+	sleep .1
+done
+echo "ino $ino iblock 3 ops read" | diff -u - <(sort -u $T_TMP.follow)
+kill "$pid"
+# silence terminated message
+wait "$pid" 2> /dev/null
+scoutfs stage "$DIR/other" "$DIR/file" -V "$vers" -o 0 -l $BYTES
+wait "$dd_pid"
+cmp "$DIR/file" "$DIR/other"
+
 echo "== cleanup"
 rm -rf "$DIR"
 
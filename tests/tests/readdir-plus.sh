@@ -0,0 +1,60 @@
+#
+# Test the _READDIR_PLUS ioctl via the readdir-plus cli command by
+# comparing its entries and attributes with readdir and stat.
+#
+
+t_require_commands scoutfs stat mkfifo createmany
+t_require_mounts 2
+
+RDP="scoutfs readdir-plus"
+
+# print the fields that stat can also print
+rdp_fields()
+{
+	$RDP "$1" | \
+	while read -r _ pos _ ino _ type _ mode _ nlink _ uid _ gid _ size \
+		      _ mtime _ dv _ online _ offline _ name; do
+		printf "%s %s %x %s %s %s %s %s\n" \
+			"$name" "$ino" "$mode" "$nlink" "$uid" "$gid" "$size" "${mtime%.*}"
+	done | sort
+}
+
+stat_fields()
+{
+	(cd "$1" && ls -A | xargs -r stat -c '%n %i %f %h %u %g %s %Y') | sort
+}
+
+echo "== empty dir returns nothing"
+mkdir "$T_D0/dir"
+$RDP "$T_D0/dir"
+
+echo "== entries match stat"
+touch "$T_D0/dir/empty"
+dd if=/dev/zero of="$T_D0/dir/file" bs=4096 count=3 status=none
+ln "$T_D0/dir/file" "$T_D0/dir/link"
+mkdir "$T_D0/dir/subdir"
+ln -s file "$T_D0/dir/symlink"
+mkfifo "$T_D0/dir/fifo"
+chown 1234:5678 "$T_D0/dir/empty"
+diff -u <(stat_fields "$T_D0/dir") <(rdp_fields "$T_D0/dir")
+
+echo "== attributes changed in another mount are current"
+echo "more" >> "$T_D1/dir/file"
+chmod 600 "$T_D1/dir/empty"
+touch -d "2001-02-03 04:05:06" "$T_D1/dir/subdir"
+diff -u <(stat_fields "$T_D0/dir") <(rdp_fields "$T_D0/dir")
+
+echo "== removed entries aren't returned"
+rm "$T_D1/dir/link" "$T_D1/dir/fifo"
+diff -u <(stat_fields "$T_D0/dir") <(rdp_fields "$T_D0/dir")
+rm -rf "$T_D0/dir"
+
+echo "== many entries are returned across calls"
+mkdir "$T_D0/dir"
+./src/createmany -o "$T_D0/dir/file_$(printf "a%.0s" {1..200})_" 10000 >> $T_TMP.log
+diff -u <(ls -A "$T_D0/dir" | sort) <(rdp_fields "$T_D0/dir" | cut -d " " -f 1 | sort)
+test "$($RDP "$T_D0/dir" | wc -l)" == 10000 || \
+	t_fail "didn't see all the entries"
+rm -rf "$T_D0/dir"
+
+t_pass
@@ -0,0 +1,72 @@
+#
+# Test releasing and staging many files by inode number with one call
+#
+
+t_require_commands dd cp cmp stat scoutfs
+
+DIR="$T_D0/dir"
+NR=200
+BS=4096
+BLOCKS=4
+
+t_quiet mkdir -p "$DIR"
+
+release_line()
+{
+	local file="$1"
+
+	echo "$(stat -c "%i" "$file") $(scoutfs stat -s data_version "$file")"
+}
+
+echo "== create files"
+dd if=/dev/urandom of="$T_TMP.golden" bs=$BS count=$BLOCKS status=none
+for i in $(seq 1 $NR); do
+	cp "$T_TMP.golden" "$DIR/file-$i"
+done
+
+echo "== release all files in one batch"
+for i in $(seq 1 $NR); do
+	release_line "$DIR/file-$i"
+done | scoutfs release-batch -p "$DIR"
+
+echo "== all files are offline"
+for i in $(seq 1 $NR); do
+	echo "$(scoutfs stat -s online_blocks "$DIR/file-$i")" \
+	     "$(scoutfs stat -s offline_blocks "$DIR/file-$i")"
+done | sort | uniq -c | sed -e 's/^ *//'
+
+echo "== stage all files back in one batch"
+for i in $(seq 1 $NR); do
+	echo "$(release_line "$DIR/file-$i") $T_TMP.golden"
+done | scoutfs stage-batch -p "$DIR"
+for i in $(seq 1 $NR); do
+	cmp "$T_TMP.golden" "$DIR/file-$i"
+done
+
+echo "== regions and failing entries don't stop the batch"
+vers=$(scoutfs stat -s data_version "$DIR/file-1")
+ino=$(stat -c "%i" "$DIR/file-1")
+(
+	echo "$ino $((vers + 1))"
+	echo "$(release_line "$DIR/file-2") $BS $BS"
+	release_line "$DIR/file-3"
+) | scoutfs release-batch -p "$DIR" 2>&1 | sed -e "s/ino $ino /ino FILE1 /"
+for i in 1 2 3; do
+	echo "file-$i: $(scoutfs stat -s online_blocks "$DIR/file-$i")" \
+	     "$(scoutfs stat -s offline_blocks "$DIR/file-$i")"
+done
+
+echo "== staging non-regular files fails without stopping the batch"
+dino=$(stat -c "%i" "$DIR")
+(
+	echo "$dino 0 $T_TMP.golden"
+	echo "$(release_line "$DIR/file-3") $T_TMP.golden"
+) | scoutfs stage-batch -p "$DIR" 2>&1 | sed -e "s/ino $dino /ino DIR /"
+cmp "$T_TMP.golden" "$DIR/file-3"
+echo "file-3: $(scoutfs stat -s online_blocks "$DIR/file-3")" \
+     "$(scoutfs stat -s offline_blocks "$DIR/file-3")"
+
+echo "== cleanup"
+rm -rf "$DIR"
+
+t_pass
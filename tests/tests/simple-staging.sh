@@ -171,6 +171,27 @@ stage_vers "$FILE" stat 0 2048 "$T_TMP"
 cmp "$FILE" "$T_TMP"
 rm -f "$FILE"
 
+echo "== stage region from start of archive file"
+create_file "$FILE" $((4096 * 64))
+cp "$FILE"  "$T_TMP"
+dd if="$FILE" of="$T_TMP.region" bs=4096 skip=16 count=32 status=none
+release_vers "$FILE" stat 0 256K
+stage_vers "$FILE" stat $((4096 * 16)) $((4096 * 32)) "$T_TMP.region"
+cmp -n $((4096 * 32)) -i $((4096 * 16)):0 "$FILE" "$T_TMP.region"
+stage_vers "$FILE" stat 0 $((4096 * 64)) "$T_TMP"
+cmp "$FILE" "$T_TMP"
+rm -f "$FILE" "$T_TMP.region"
+
+echo "== stage from archive shorter than length fails"
+create_file "$FILE" $((4096 * 8))
+cp "$FILE"  "$T_TMP"
+head -c $((4096 * 4 + 100)) "$T_TMP" > "$T_TMP.short"
+release_vers "$FILE" stat 0 32K
+stage_vers "$FILE" stat 0 $((4096 * 8)) "$T_TMP.short"
+stage_vers "$FILE" stat 0 $((4096 * 8)) "$T_TMP"
+cmp "$FILE" "$T_TMP"
+rm -f "$FILE" "$T_TMP.short"
+
 echo "== zero length stage doesn't bring blocks online"
 create_file "$FILE" $((4096 * 100))
 release_vers "$FILE" stat 0 400K
@@ -43,8 +43,104 @@ static int cmp_counter_names(const void *A, const void *B)
 struct counters_args {
 	char *sysfs_path;
 	bool tabular;
+	bool latency;
 };
 
+#define LAT_BUCKETS 32
+
+/* the first bucket whose count reaches the given percent of the total */
+static int pct_bucket(unsigned long long *counts, unsigned long long total,
+		      unsigned int pct)
+{
+	unsigned long long target = ((total * pct) + 99) / 100;
+	unsigned long long sum = 0;
+	int b;
+
+	for (b = 0; b < LAT_BUCKETS - 1; b++) {
+		sum += counts[b];
+		if (sum >= target)
+			break;
+	}
+
+	return b;
+}
+
+/*
+ * Each line of the net/latency file is a kind and command followed by
+ * bucket:count pairs for the non-zero buckets of a log2 histogram.
+ * Bucket b counts latencies under 2^b microseconds.  We summarize each
+ * histogram with its total count and the upper bound of the buckets
+ * that contain its percentiles.
+ */
+static int print_latency(char *sysfs_path)
+{
+	unsigned long long counts[LAT_BUCKETS];
+	unsigned long long total;
+	unsigned long long count;
+	char path[PATH_MAX + 1];
+	char *line = NULL;
+	size_t size = 0;
+	char kind[32];
+	char cmd[64];
+	char *tok;
+	FILE *fp;
+	int max;
+	int ret;
+	int off;
+	int b;
+
+	ret = snprintf(path, PATH_MAX, "%s/net/latency", sysfs_path);
+	if (ret < 1 || ret >= PATH_MAX) {
+		fprintf(stderr, "invalid latency file path '%s'\n", sysfs_path);
+		return -EINVAL;
+	}
+
+	fp = fopen(path, "r");
+	if (!fp) {
+		ret = -errno;
+		fprintf(stderr, "failed to open latency file '%s': %s (%d)\n",
+			path, strerror(errno), errno);
+		return ret;
+	}
+
+	printf("%-8s %-20s %10s %10s %10s %10s %10s\n",
+	       "kind", "cmd", "count", "p50_us", "p90_us", "p99_us", "max_us");
+
+	while (getline(&line, &size, fp) > 0) {
+		if (sscanf(line, "%31s %63s%n", kind, cmd, &off) != 2)
+			continue;
+
+		memset(counts, 0, sizeof(counts));
+		total = 0;
+		max = 0;
+
+		for (tok = strtok(line + off, " \n"); tok;
+		     tok = strtok(NULL, " \n")) {
+			if (sscanf(tok, "%d:%llu", &b, &count) != 2 ||
+			    b < 0 || b >= LAT_BUCKETS)
+				continue;
+			counts[b] = count;
+			total += count;
+			if (count)
+				max = b;
+		}
+
+		if (total == 0)
+			continue;
+
+		printf("%-8s %-20s %10llu %10llu %10llu %10llu %10llu\n",
+		       kind, cmd, total,
+		       1ULL << pct_bucket(counts, total, 50),
+		       1ULL << pct_bucket(counts, total, 90),
+		       1ULL << pct_bucket(counts, total, 99),
+		       1ULL << max);
+	}
+
+	free(line);
+	fclose(fp);
+	return 0;
+}
+
 static int do_counters(struct counters_args *args)
 {
 	unsigned int *name_wid = NULL;
@@ -168,7 +264,7 @@ static int do_counters(struct counters_args *args)
 	/* huh, empty counter dir */
 	if (nr == 0) {
 		ret = 0;
-		goto out;
+		goto latency;
 	}
 
 	/* sort counters by name */
@@ -252,7 +348,12 @@ static int do_counters(struct counters_args *args)
 		printf("\n");
 	}
 
+latency:
 	ret = 0;
+	if (args->latency) {
+		printf("\n");
+		ret = print_latency(args->sysfs_path);
+	}
 out:
 	if (dirp)
 		closedir(dirp);
@@ -279,6 +380,9 @@ static int parse_opt(int key, char *arg, struct argp_state *state)
 	case 't':
 		args->tabular = true;
 		break;
+	case 'l':
+		args->latency = true;
+		break;
 	case ARGP_KEY_ARG:
 		if (!args->sysfs_path)
 			args->sysfs_path = strdup_or_error(state, arg);
@@ -299,6 +403,7 @@ static int parse_opt(int key, char *arg, struct argp_state *state)
 
 static struct argp_option options[] = {
 	{ "table", 't', NULL, 0, "Output in table format" },
+	{ "latency", 'l', NULL, 0, "Also output net command latency histograms" },
 	{ NULL }
 };
 
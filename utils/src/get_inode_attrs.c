@@ -0,0 +1,158 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <argp.h>
+
+#include "sparse.h"
+#include "parse.h"
+#include "util.h"
+#include "format.h"
+#include "ioctl.h"
+#include "cmd.h"
+
+#define ATTRS_NR 1024
+
+struct get_inode_attrs_args {
+	char *path;
+	u64 first_ino;
+	u64 last_ino;
+	u64 min_meta_seq;
+	u64 min_data_seq;
+};
+
+static int do_get_inode_attrs(struct get_inode_attrs_args *args)
+{
+	struct scoutfs_ioctl_get_inode_attrs gia;
+	struct scoutfs_ioctl_inode_attrs *attrs;
+	struct scoutfs_ioctl_inode_attrs *at;
+	int fd = -1;
+	int ret;
+	int i;
+
+	attrs = calloc(ATTRS_NR, sizeof(attrs[0]));
+	if (!attrs) {
+		fprintf(stderr, "inode attributes array allocation failed\n");
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	fd = get_path(args->path, O_RDONLY);
+	if (fd < 0) {
+		ret = fd;
+		goto out;
+	}
+
+	memset(&gia, 0, sizeof(gia));
+	gia.first_ino = args->first_ino;
+	gia.last_ino = args->last_ino;
+	gia.min_meta_seq = args->min_meta_seq;
+	gia.min_data_seq = args->min_data_seq;
+	gia.attrs_ptr = (unsigned long)attrs;
+	gia.attrs_nr = ATTRS_NR;
+
+	for (;;) {
+		ret = ioctl(fd, SCOUTFS_IOC_GET_INODE_ATTRS, &gia);
+		if (ret <= 0) {
+			if (ret < 0) {
+				ret = -errno;
+				fprintf(stderr, "get_inode_attrs ioctl failed: %s (%d)\n",
+					strerror(errno), errno);
+			}
+			goto out;
+		}
+
+		for (i = 0; i < ret; i++) {
+			at = &attrs[i];
+			printf("ino %llu mode 0%o nlink %u uid %u gid %u size %llu "
+			       "mtime %llu.%09u meta_seq %llu data_seq %llu data_version %llu "
+			       "online_blocks %llu offline_blocks %llu\n",
+			       at->ino, at->mode, at->nlink, at->uid, at->gid, at->size,
+			       at->mtime_sec, at->mtime_nsec, at->meta_seq, at->data_seq,
+			       at->data_version, at->online_blocks, at->offline_blocks);
+		}
+	}
+
+out:
+	if (fd >= 0)
+		close(fd);
+	free(attrs);
+
+	return ret;
+};
+
+static int parse_opt(int key, char *arg, struct argp_state *state)
+{
+	struct get_inode_attrs_args *args = state->input;
+	int ret;
+
+	switch (key) {
+	case 'f':
+		ret = parse_u64(arg, &args->first_ino);
+		if (ret)
+			return ret;
+		break;
+	case 'l':
+		ret = parse_u64(arg, &args->last_ino);
+		if (ret)
+			return ret;
+		break;
+	case 'm':
+		ret = parse_u64(arg, &args->min_meta_seq);
+		if (ret)
+			return ret;
+		break;
+	case 'd':
+		ret = parse_u64(arg, &args->min_data_seq);
+		if (ret)
+			return ret;
+		break;
+	case 'p':
+		args->path = strdup_or_error(state, arg);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp_option options[] = {
+	{ "first", 'f', "INO", 0, "First inode number to scan (default 0)"},
+	{ "last", 'l', "INO", 0, "Last inode number to scan (default last possible)"},
+	{ "min-meta-seq", 'm', "SEQ", 0, "Only print inodes with at least this meta_seq"},
+	{ "min-data-seq", 'd', "SEQ", 0, "Only print inodes with at least this data_seq"},
+	{ "path", 'p', "PATH", 0, "Path to ScoutFS filesystem"},
+	{ NULL }
+};
+
+static struct argp argp = {
+	options,
+	parse_opt,
+	NULL,
+	"Print the attributes of all the inodes in a range of inode numbers"
+};
+
+static int get_inode_attrs_cmd(int argc, char **argv)
+{
+	struct get_inode_attrs_args args = {
+		.last_ino = U64_MAX,
+	};
+	int ret;
+
+	ret = argp_parse(&argp, argc, argv, 0, NULL, &args);
+	if (ret)
+		return ret;
+
+	return do_get_inode_attrs(&args);
+}
+
+static void __attribute__((constructor)) get_inode_attrs_ctor(void)
+{
+	cmd_register_argp("get-inode-attrs", &argp, GROUP_SEARCH, get_inode_attrs_cmd);
+}
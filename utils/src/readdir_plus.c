@@ -0,0 +1,125 @@
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/ioctl.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <string.h>
+#include <limits.h>
+#include <argp.h>
+
+#include "sparse.h"
+#include "parse.h"
+#include "util.h"
+#include "format.h"
+#include "ioctl.h"
+#include "cmd.h"
+
+struct rdp_args {
+	char *path;
+};
+
+static int do_readdir_plus(struct rdp_args *args)
+{
+	struct scoutfs_ioctl_readdir_plus_entry *ent;
+	struct scoutfs_ioctl_readdir_plus rdp;
+	unsigned int bytes;
+	void *buf = NULL;
+	int ret;
+	int fd;
+
+	fd = get_path(args->path, O_RDONLY | O_DIRECTORY);
+	if (fd < 0)
+		return fd;
+
+	bytes = PATH_MAX * 64;
+	ret = posix_memalign(&buf, 16, bytes);
+	if (ret) {
+		fprintf(stderr, "couldn't allocate %u byte buffer\n", bytes);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	memset(&rdp, 0, sizeof(rdp));
+	rdp.entries_ptr = (intptr_t)buf;
+	rdp.entries_bytes = bytes;
+
+	for (;;) {
+		ret = ioctl(fd, SCOUTFS_IOC_READDIR_PLUS, &rdp);
+		if (ret <= 0) {
+			if (ret < 0) {
+				ret = -errno;
+				fprintf(stderr, "readdir_plus ioctl failed: %s (%d)\n",
+					strerror(errno), errno);
+			}
+			goto out;
+		}
+
+		ent = buf;
+		while (ret-- > 0) {
+			printf("pos %llu ino %llu type %u mode 0%o nlink %u uid %u gid %u "
+			       "size %llu mtime %llu.%09u data_version %llu "
+			       "online_blocks %llu offline_blocks %llu name %s\n",
+			       ent->pos, ent->attrs.ino, ent->d_type, ent->attrs.mode,
+			       ent->attrs.nlink, ent->attrs.uid, ent->attrs.gid,
+			       ent->attrs.size, ent->attrs.mtime_sec, ent->attrs.mtime_nsec,
+			       ent->attrs.data_version, ent->attrs.online_blocks,
+			       ent->attrs.offline_blocks, ent->name);
+
+			ent = (void *)ent + ent->entry_bytes;
+		}
+	}
+
+out:
+	close(fd);
+	free(buf);
+
+	return ret;
+};
+
+static int parse_opt(int key, char *arg, struct argp_state *state)
+{
+	struct rdp_args *args = state->input;
+
+	switch (key) {
+	case ARGP_KEY_ARG:
+		if (args->path)
+			argp_error(state, "more than one argument given");
+		args->path = strdup_or_error(state, arg);
+		break;
+	case ARGP_KEY_FINI:
+		if (!args->path)
+			argp_error(state, "must provide directory path");
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp argp = {
+	NULL,
+	parse_opt,
+	"DIR",
+	"Print directory entries and the attributes of their inodes"
+};
+
+static int readdir_plus_cmd(int argc, char **argv)
+{
+	struct rdp_args args = {NULL};
+	int ret;
+
+	ret = argp_parse(&argp, argc, argv, 0, NULL, &args);
+	if (ret)
+		return ret;
+
+	return do_readdir_plus(&args);
+}
+
+static void __attribute__((constructor)) readdir_plus_ctor(void)
+{
+	cmd_register_argp("readdir-plus", &argp, GROUP_INFO, readdir_plus_cmd);
+}
@@ -9,6 +9,7 @@
 #include <string.h>
 #include <limits.h>
 #include <argp.h>
+#include <stdbool.h>
 
 #include "sparse.h"
 #include "util.h"
@@ -25,6 +26,52 @@ struct stage_args {
 	u64 length;
 };
 
+/*
+ * Try to have the kernel splice the archive file's pages into the
+ * staged file.  Returns -EOPNOTSUPP if the kernel or the archive file
+ * doesn't support it and the caller should read and stage from a
+ * buffer.  The offset and length are advanced as regions are staged.
+ */
+static int stage_fd(int fd, int afd, struct stage_args *args)
+{
+	struct scoutfs_ioctl_stage_fd sfd;
+	u64 from_off = 0;
+	long ret;
+
+	while (args->length) {
+		sfd.data_version = args->data_version;
+		sfd.from_fd = afd;
+		sfd.from_off = from_off;
+		sfd.offset = args->offset;
+		sfd.length = args->length;
+
+		ret = ioctl(fd, SCOUTFS_IOC_STAGE_FD, &sfd);
+		if (ret < 0 && (errno == ENOTTY || errno == EOPNOTSUPP)) {
+			ret = -EOPNOTSUPP;
+			goto out;
+		}
+		if (ret <= 0 || ret > args->length) {
+			fprintf(stderr, "stage returned %ld, not %llu: error %s (%d)\n",
+				ret, args->length, strerror(errno), errno);
+			ret = -EIO;
+			goto out;
+		}
+
+		from_off += ret;
+		args->offset += ret;
+		args->length -= ret;
+	}
+
+	ret = 0;
+out:
+	if (ret == -EOPNOTSUPP && lseek(afd, from_off, SEEK_SET) < 0) {
+		ret = -errno;
+		fprintf(stderr, "archive seek failed: %s (%d)\n",
+			strerror(errno), errno);
+	}
+	return ret;
+}
+
 static int do_stage(struct stage_args *args)
 {
 	struct scoutfs_ioctl_stage ioctl_args;
@@ -51,6 +98,10 @@ static int do_stage(struct stage_args *args)
 		return ret;
 	}
 
+	ret = stage_fd(fd, afd, args);
+	if (ret != -EOPNOTSUPP)
+		goto out;
+
 	buf = malloc(buf_len);
 	if (!buf) {
 		fprintf(stderr, "couldn't allocate %u byte buffer\n", buf_len);
@@ -296,3 +347,354 @@ static void __attribute__((constructor)) release_ctor(void)
 {
 	cmd_register_argp("release", &release_argp, GROUP_AGENT, release_cmd);
 }
+
+struct release_batch_args {
+	char *path;
+};
+
+/*
+ * Returns -EIO if any entries failed, after printing their errors.
+ * Staged entries have failed if they didn't stage their full length.
+ */
+static int batch_ioctl(int fd, struct scoutfs_ioctl_batch_entry *ents,
+		       unsigned int nr, bool stage)
+{
+	struct scoutfs_ioctl_batch batch = {
+		.ents_ptr = (unsigned long)ents,
+		.ents_nr = nr,
+		.flags = 0,
+	};
+	char *which = stage ? "stage" : "release";
+	int ret;
+	int i;
+
+	ret = ioctl(fd, stage ? SCOUTFS_IOC_STAGE_BATCH : SCOUTFS_IOC_RELEASE_BATCH,
+		    &batch);
+	if (ret < 0) {
+		ret = -errno;
+		fprintf(stderr, "%s batch ioctl failed: %s (%d)\n",
+			which, strerror(errno), errno);
+		return ret;
+	}
+	if (ret != nr) {
+		fprintf(stderr, "%s batch processed %d of %u entries\n",
+			which, ret, nr);
+		return -EIO;
+	}
+
+	ret = 0;
+	for (i = 0; i < nr; i++) {
+		if (ents[i].result < 0) {
+			fprintf(stderr, "%s of ino %llu failed: %s (%lld)\n",
+				which, ents[i].ino, strerror(-ents[i].result),
+				ents[i].result);
+			ret = -EIO;
+		} else if (stage && ents[i].result != ents[i].length) {
+			fprintf(stderr, "stage of ino %llu at offset %llu staged %lld of %llu bytes\n",
+				ents[i].ino, ents[i].offset, ents[i].result,
+				ents[i].length);
+			ret = -EIO;
+		}
+	}
+
+	return ret;
+}
+
+/*
+ * Read lines of "INO VERSION [OFFSET LENGTH]" from stdin and release
+ * them in batches.  The entire file is released if the region isn't
+ * given.
+ */
+static int do_release_batch(struct release_batch_args *args)
+{
+	struct scoutfs_ioctl_batch_entry *ents = NULL;
+	unsigned int ents_max = 1024;
+	unsigned long long ino;
+	unsigned long long vers;
+	unsigned long long off;
+	unsigned long long len;
+	unsigned int nr = 0;
+	char line[256];
+	int ret = 0;
+	int err;
+	int fd;
+	int n;
+
+	fd = get_path(args->path, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	ents = calloc(ents_max, sizeof(ents[0]));
+	if (!ents) {
+		fprintf(stderr, "couldn't allocate %u batch entries\n", ents_max);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	while (fgets(line, sizeof(line), stdin)) {
+		n = sscanf(line, "%llu %llu %llu %llu", &ino, &vers, &off, &len);
+		if (n == 2) {
+			off = 0;
+			len = ~((unsigned long long)SCOUTFS_BLOCK_SM_SIZE - 1);
+		} else if (n != 4) {
+			fprintf(stderr, "invalid release line: %s", line);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		ents[nr].ino = ino;
+		ents[nr].data_version = vers;
+		ents[nr].offset = off;
+		ents[nr].length = len;
+		ents[nr].buf_ptr = 0;
+		ents[nr].result = 0;
+
+		if (++nr == ents_max) {
+			err = batch_ioctl(fd, ents, nr, false);
+			if (err < 0) {
+				ret = err;
+				/* keep going after failed entries */
+				if (err != -EIO)
+					goto out;
+			}
+			nr = 0;
+		}
+	}
+
+	if (nr) {
+		err = batch_ioctl(fd, ents, nr, false);
+		if (err < 0)
+			ret = err;
+	}
+
+out:
+	free(ents);
+	close(fd);
+	return ret;
+}
+
+static int parse_release_batch_opts(int key, char *arg, struct argp_state *state)
+{
+	struct release_batch_args *args = state->input;
+
+	switch (key) {
+	case 'p':
+		args->path = strdup_or_error(state, arg);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp_option release_batch_options[] = {
+	{ "path", 'p', "PATH", 0, "Path to ScoutFS filesystem"},
+	{ NULL }
+};
+
+static struct argp release_batch_argp = {
+	release_batch_options,
+	parse_release_batch_opts,
+	"",
+	"Release files by inode number read from stdin"
+};
+
+static int release_batch_cmd(int argc, char **argv)
+{
+	struct release_batch_args release_batch_args = {NULL};
+	int ret;
+
+	ret = argp_parse(&release_batch_argp, argc, argv, 0, NULL,
+			 &release_batch_args);
+	if (ret)
+		return ret;
+
+	return do_release_batch(&release_batch_args);
+}
+
+static void __attribute__((constructor)) release_batch_ctor(void)
+{
+	cmd_register_argp("release-batch", &release_batch_argp, GROUP_AGENT,
+			  release_batch_cmd);
+}
+
+struct stage_batch_args {
+	char *path;
+};
+
+#define STAGE_BATCH_BUF_LEN	(1024 * 1024)
+#define STAGE_BATCH_ENTS_MAX	64
+
+static int stage_batch_flush(int fd, struct scoutfs_ioctl_batch_entry *ents,
+			     unsigned int nr)
+{
+	int ret;
+	int i;
+
+	ret = batch_ioctl(fd, ents, nr, true);
+
+	for (i = 0; i < nr; i++) {
+		free((void *)(unsigned long)ents[i].buf_ptr);
+		ents[i].buf_ptr = 0;
+	}
+
+	return ret;
+}
+
+/*
+ * Read lines of "INO VERSION ARCHIVE" from stdin and stage the entire
+ * contents of each archive file into the released file with the inode
+ * number.  The archive files are read into buffers that are staged in
+ * batches of entries.
+ */
+static int do_stage_batch(struct stage_batch_args *args)
+{
+	struct scoutfs_ioctl_batch_entry *ents = NULL;
+	unsigned long long ino;
+	unsigned long long vers;
+	unsigned long long off;
+	char archive[PATH_MAX];
+	unsigned int nr = 0;
+	char line[PATH_MAX + 64];
+	ssize_t bytes;
+	char *buf;
+	int afd = -1;
+	int ret = 0;
+	int err;
+	int fd;
+
+	fd = get_path(args->path, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	ents = calloc(STAGE_BATCH_ENTS_MAX, sizeof(ents[0]));
+	if (!ents) {
+		fprintf(stderr, "couldn't allocate %u batch entries\n",
+			STAGE_BATCH_ENTS_MAX);
+		ret = -ENOMEM;
+		goto out;
+	}
+
+	while (fgets(line, sizeof(line), stdin)) {
+		if (sscanf(line, "%llu %llu %4095s", &ino, &vers, archive) != 3) {
+			fprintf(stderr, "invalid stage line: %s", line);
+			ret = -EINVAL;
+			goto out;
+		}
+
+		afd = open(archive, O_RDONLY);
+		if (afd < 0) {
+			ret = -errno;
+			fprintf(stderr, "failed to open '%s': %s (%d)\n",
+				archive, strerror(errno), errno);
+			goto out;
+		}
+
+		for (off = 0; ; off += bytes) {
+			buf = malloc(STAGE_BATCH_BUF_LEN);
+			if (!buf) {
+				fprintf(stderr, "couldn't allocate %u byte buffer\n",
+					STAGE_BATCH_BUF_LEN);
+				ret = -ENOMEM;
+				goto out;
+			}
+
+			bytes = read(afd, buf, STAGE_BATCH_BUF_LEN);
+			if (bytes <= 0) {
+				free(buf);
+				if (bytes == 0)
+					break;
+				ret = -errno;
+				fprintf(stderr, "archive '%s' read failed: %s (%d)\n",
+					archive, strerror(errno), errno);
+				goto out;
+			}
+
+			ents[nr].ino = ino;
+			ents[nr].data_version = vers;
+			ents[nr].offset = off;
+			ents[nr].length = bytes;
+			ents[nr].buf_ptr = (unsigned long)buf;
+			ents[nr].result = 0;
+
+			if (++nr == STAGE_BATCH_ENTS_MAX) {
+				err = stage_batch_flush(fd, ents, nr);
+				nr = 0;
+				if (err < 0) {
+					ret = err;
+					/* keep going after failed entries */
+					if (err != -EIO)
+						goto out;
+				}
+			}
+		}
+
+		close(afd);
+		afd = -1;
+	}
+
+	if (nr) {
+		err = stage_batch_flush(fd, ents, nr);
+		nr = 0;
+		if (err < 0)
+			ret = err;
+	}
+
+out:
+	if (ents) {
+		while (nr > 0)
+			free((void *)(unsigned long)ents[--nr].buf_ptr);
+		free(ents);
+	}
+	if (afd >= 0)
+		close(afd);
+	close(fd);
+	return ret;
+}
+
+static int parse_stage_batch_opts(int key, char *arg, struct argp_state *state)
+{
+	struct stage_batch_args *args = state->input;
+
+	switch (key) {
+	case 'p':
+		args->path = strdup_or_error(state, arg);
+		break;
+	default:
+		break;
+	}
+
+	return 0;
+}
+
+static struct argp_option stage_batch_options[] = {
+	{ "path", 'p', "PATH", 0, "Path to ScoutFS filesystem"},
+	{ NULL }
+};
+
+static struct argp stage_batch_argp = {
+	stage_batch_options,
+	parse_stage_batch_opts,
+	"",
+	"Stage archive files into files by inode number read from stdin"
+};
+
+static int stage_batch_cmd(int argc, char **argv)
+{
+	struct stage_batch_args stage_batch_args = {NULL};
+	int ret;
+
+	ret = argp_parse(&stage_batch_argp, argc, argv, 0, NULL,
+			 &stage_batch_args);
+	if (ret)
+		return ret;
+
+	return do_stage_batch(&stage_batch_args);
+}
+
+static void __attribute__((constructor)) stage_batch_ctor(void)
+{
+	cmd_register_argp("stage-batch", &stage_batch_argp, GROUP_AGENT,
+			  stage_batch_cmd);
+}
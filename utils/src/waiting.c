@@ -10,6 +10,7 @@
 #include <limits.h>
 #include <argp.h>
 #include <stdbool.h>
+#include <poll.h>
 
 #include "sparse.h"
 #include "util.h"
@@ -40,20 +41,29 @@ struct waiting_args {
 	u64 inode;
 	bool blkno_set;
 	u64 blkno;
+	bool follow;
 };
 
-static int do_waiting(struct waiting_args *args)
+static void print_entry(struct scoutfs_ioctl_data_waiting_entry *dwe)
+{
+	printf("ino %llu iblock %llu ops "
+	       OP_FMT OP_FMT OP_FMT"\n",
+	       dwe->ino, dwe->iblock,
+	       op_str(dwe->op, SCOUTFS_IOC_DWO_READ,
+		      "read"),
+	       op_str(dwe->op, SCOUTFS_IOC_DWO_WRITE,
+		      "write"),
+	       op_str(dwe->op, SCOUTFS_IOC_DWO_CHANGE_SIZE,
+		      "change_size"));
+}
+
+static int print_waiting(int fd, struct waiting_args *args)
 {
 	struct scoutfs_ioctl_data_waiting_entry dwe[16];
 	struct scoutfs_ioctl_data_waiting idw;
 	int ret;
-	int fd;
 	int i;
 
-	fd = get_path(args->path, O_RDONLY);
-	if (fd < 0)
-		return fd;
-
 	idw.flags = 0;
 	idw.after_ino = args->inode;
 	idw.after_iblock = args->blkno;
@@ -72,20 +82,92 @@ static int do_waiting(struct waiting_args *args)
 		}
 
 		for (i = 0; i < ret; i++)
-			printf("ino %llu iblock %llu ops "
-			       OP_FMT OP_FMT OP_FMT"\n",
-			       dwe[i].ino, dwe[i].iblock,
-			       op_str(dwe[i].op, SCOUTFS_IOC_DWO_READ,
-				      "read"),
-			       op_str(dwe[i].op, SCOUTFS_IOC_DWO_WRITE,
-				      "write"),
-			       op_str(dwe[i].op, SCOUTFS_IOC_DWO_CHANGE_SIZE,
-				      "change_size"));
+			print_entry(&dwe[i]);
 
 		idw.after_ino = dwe[i - 1].ino;
 		idw.after_iblock = dwe[i - 1].iblock;
 	}
 
+	return ret;
+}
+
+/*
+ * Print waiters as they arrive.  We get the events fd before printing
+ * the existing waiters so that we can't miss waiters that arrive in
+ * between.  We print all the existing waiters again if the kernel had
+ * to drop events because we fell behind.
+ */
+static int follow_waiting(int fd, struct waiting_args *args)
+{
+	struct scoutfs_ioctl_data_waiting_events dwev = { .flags = 0 };
+	struct scoutfs_ioctl_data_waiting_entry dwe[16];
+	struct pollfd pfd;
+	ssize_t bytes;
+	int evfd;
+	int ret;
+	int i;
+
+	evfd = ioctl(fd, SCOUTFS_IOC_DATA_WAITING_EVENTS, &dwev);
+	if (evfd < 0) {
+		ret = -errno;
+		fprintf(stderr, "waiting events ioctl failed: %s (%d)\n",
+			strerror(errno), errno);
+		return ret;
+	}
+
+	ret = print_waiting(fd, args);
+	fflush(stdout);
+
+	pfd.fd = evfd;
+	pfd.events = POLLIN;
+
+	while (ret == 0) {
+		ret = poll(&pfd, 1, -1);
+		if (ret < 0) {
+			ret = -errno;
+			fprintf(stderr, "waiting events poll failed: %s (%d)\n",
+				strerror(errno), errno);
+			break;
+		}
+
+		bytes = read(evfd, dwe, sizeof(dwe));
+		if (bytes < 0 && errno == EOVERFLOW) {
+			ret = print_waiting(fd, args);
+		} else if (bytes < 0) {
+			ret = -errno;
+			fprintf(stderr, "waiting events read failed: %s (%d)\n",
+				strerror(errno), errno);
+		} else {
+			for (i = 0; i < bytes / sizeof(dwe[0]); i++) {
+				if (dwe[i].ino < args->inode ||
+				    (dwe[i].ino == args->inode &&
+				     dwe[i].iblock <= args->blkno))
+					continue;
+				print_entry(&dwe[i]);
+			}
+			ret = 0;
+		}
+		fflush(stdout);
+	}
+
+	close(evfd);
+	return ret;
+}
+
+static int do_waiting(struct waiting_args *args)
+{
+	int ret;
+	int fd;
+
+	fd = get_path(args->path, O_RDONLY);
+	if (fd < 0)
+		return fd;
+
+	if (args->follow)
+		ret = follow_waiting(fd, args);
+	else
+		ret = print_waiting(fd, args);
+
 	close(fd);
 	return ret;
 };
@@ -111,6 +193,9 @@ static int waiting_parse_opt(int key, char *arg, struct argp_state *state)
 			argp_error(state, "blkno parse error");
 		args->blkno_set = true;
 		break;
+	case 'f': /* follow */
+		args->follow = true;
+		break;
 	case ARGP_KEY_FINI:
 		if (!args->inode_set)
 			argp_error(state, "no inode given");
@@ -128,13 +213,14 @@ static struct argp_option waiting_options[] = {
 	{ "path", 'p', "PATH", 0, "Path to ScoutFS filesystem"},
 	{ "inode", 'I', "INODE-NUM", 0, "Inode number [Required]"},
 	{ "block", 'B', "BLKNO-NUM", 0, "Block number [Required]"},
+	{ "follow", 'f', NULL, 0, "Keep printing waiters as they arrive"},
 	{ NULL }
 };
 
 static struct argp waiting_argp = {
 	waiting_options,
 	waiting_parse_opt,
-	"--inode INODE-NUM --block BLOCK-NUM",
+	"--inode INODE-NUM --block BLOCK-NUM [--follow]",
 	"Print operations waiting for data blocks"
 };
 